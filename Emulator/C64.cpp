@@ -71,7 +71,8 @@ C64::C64()
         &drive9,
         &datasette,
         &mouse,
-        &oscillator
+        &oscillator,
+        &rewind
     };
     
     // Set up the initial state
@@ -187,6 +188,8 @@ C64::getConfigItem(ConfigOption option)
         case OPT_CUT_OPACITY:
         case OPT_SS_COLLISIONS:
         case OPT_SB_COLLISIONS:
+        case OPT_RENDER_INTERVAL:
+        case OPT_FRAMEBUFFER:
             return vic.getConfigItem(option);
                         
         case OPT_CIA_REVISION:
@@ -204,6 +207,14 @@ C64::getConfigItem(ConfigOption option)
         case OPT_DEBUGCART:
             return mem.getConfigItem(option);
 
+        case OPT_LAZY_DRIVES:
+            return iec.getConfigItem(option);
+
+        case OPT_REWIND_BUFFER:
+        case OPT_REWIND_INTERVAL:
+        case OPT_REWIND_KEYFRAMES:
+            return rewind.getConfigItem(option);
+
         default:
             assert(false);
             return 0;
@@ -665,6 +676,15 @@ C64::_dump()
     msg("\n");
 }
 
+size_t
+C64::willSaveToBuffer(u8 *buffer)
+{
+    // Snapshots must not contain drives that lag behind
+    iec.catchUpDrives(cpu.cycle);
+    
+    return 0;
+}
+
 void
 C64::_setWarp(bool enable)
 {
@@ -809,6 +829,9 @@ C64::runLoop()
         // Check if special action needs to be taken
         if (runLoopCtrl) {
             
+            // Bring lazily emulated drives up to date
+            iec.catchUpDrives(cpu.cycle);
+            
             // Are we requested to take a snapshot?
             if (runLoopCtrl & RL_AUTO_SNAPSHOT) {
                 debug(RUN_DEBUG, "RL_AUTO_SNAPSHOT\n");
@@ -823,6 +846,13 @@ C64::runLoop()
                 clearControlFlags(RL_USER_SNAPSHOT);
             }
             
+            // Are we requested to travel back in time?
+            if (runLoopCtrl & RL_REWIND) {
+                debug(RUN_DEBUG, "RL_REWIND\n");
+                clearControlFlags(RL_REWIND);
+                if (rewind.seek(rewind.target)) oscillator.restart();
+            }
+            
             // Are we requested to update the debugger info structs?
             if (runLoopCtrl & RL_INSPECT) {
                 debug(RUN_DEBUG, "RL_INSPECT\n");
@@ -911,6 +941,16 @@ C64::executeOneFrame()
 
 void
 C64::executeOneLine()
+{
+    if (cpu.inDebugCore()) {
+        _executeOneLine<true>();
+    } else {
+        _executeOneLine<false>();
+    }
+}
+
+template <bool dbg> void
+C64::_executeOneLine()
 {
     // Emulate the beginning of a rasterline
     if (rasterCycle == 1) beginRasterLine();
@@ -919,7 +959,7 @@ C64::executeOneLine()
     unsigned lastCycle = vic.getCyclesPerLine();
     for (unsigned i = rasterCycle; i <= lastCycle; i++) {
         
-        _executeOneCycle();
+        _executeOneCycle<dbg>();
         if (runLoopCtrl != 0) {
             if (i == lastCycle) endRasterLine();
             return;
@@ -937,11 +977,11 @@ C64::executeOneCycle()
     bool isLastCycle = vic.isLastCycleInRasterline(rasterCycle);
     
     if (isFirstCycle) beginRasterLine();
-    _executeOneCycle();
+    if (cpu.inDebugCore()) _executeOneCycle<true>(); else _executeOneCycle<false>();
     if (isLastCycle) endRasterLine();
 }
 
-void
+template <bool dbg> void
 C64::_executeOneCycle()
 {
     Cycle cycle = ++cpu.cycle;
@@ -966,19 +1006,31 @@ C64::_executeOneCycle()
     
     // First clock phase (o2 low)
     (vic.*vicfunc[rasterCycle])();
-    if (cycle >= cia1.wakeUpCycle) cia1.executeOneCycle();
-    if (cycle >= cia2.wakeUpCycle) cia2.executeOneCycle();
-    if (iec.isDirtyC64Side) iec.updateIecLinesC64Side();
+    if (cycle >= scheduler.nextPrimary) executePrimaryEvents(cycle);
     
     // Second clock phase (o2 high)
-    cpu.executeOneCycle();
-    if (drive8.isActive()) drive8.execute(durationOfOneCycle);
-    if (drive9.isActive()) drive9.execute(durationOfOneCycle);
-    datasette.execute();
+    cpu.executeOneCycle<dbg>();
+    if (cycle >= scheduler.nextSecondary) executeSecondaryEvents(cycle);
     
     rasterCycle++;
 }
 
+void
+C64::executePrimaryEvents(Cycle cycle)
+{
+    if (scheduler.isDue(EVENT_CIA1, cycle)) cia1.executeOneCycle();
+    if (scheduler.isDue(EVENT_CIA2, cycle)) cia2.executeOneCycle();
+    if (scheduler.isDue(EVENT_IEC, cycle)) iec.updateIecLinesC64Side();
+}
+
+void
+C64::executeSecondaryEvents(Cycle cycle)
+{
+    if (scheduler.isDue(EVENT_DRIVE8, cycle)) drive8.execute(durationOfOneCycle);
+    if (scheduler.isDue(EVENT_DRIVE9, cycle)) drive9.execute(durationOfOneCycle);
+    if (scheduler.isDue(EVENT_DATASETTE, cycle)) datasette.execute(cycle);
+}
+
 void
 C64::finishInstruction()
 {
@@ -1011,8 +1063,12 @@ C64::endRasterLine()
 void
 C64::endFrame()
 {
+    // Bring lazily emulated drives up to date
+    iec.catchUpDrives(cpu.cycle);
+    
     frame++;
     vic.endFrame();
+    if (MEM_HEATMAP && mem.recordingHeatmap) mem.heatmap->endFrame();
     
     // Increment time of day clocks every tenth of a second
     cia1.incrementTOD();
@@ -1033,6 +1089,9 @@ C64::endFrame()
     // Update mouse coordinates
     mouse.execute();
     
+    // Record the emulator state
+    rewind.vsyncHandler();
+    
     // Check if the run loop is requested to stop
     if (stopFlag) { stopFlag = false; signalStop(); }
     
@@ -1154,6 +1213,22 @@ C64::latestUserSnapshot()
     return result;
 }
 
+void
+C64::requestRewind(u64 frame)
+{
+    if (!isRunning()) {
+        
+        // Travel back immediately
+        rewind.seek(frame);
+        
+    } else {
+        
+        // Schedule the request
+        rewind.target = frame;
+        setControlFlags(RL_REWIND);
+    }
+}
+
 void C64::loadFromSnapshot(Snapshot *snapshot)
 {
     u8 *ptr;
@@ -1163,17 +1238,29 @@ void C64::loadFromSnapshot(Snapshot *snapshot)
         // Make sure the emulator is not running
         assert(!isRunning());
         
-        // Restore the saved state
-        load(ptr);
-        
-        // Clear the keyboard matrix to avoid constantly pressed keys
-        keyboard.releaseAll();
+        loadFromBuffer(ptr);
         
-        // Inform the GUI
-        messageQueue.put(MSG_SNAPSHOT_RESTORED);
+        // The recorded history belongs to another timeline now
+        rewind.clear();
     }
 }
 
+void
+C64::loadFromBuffer(u8 *buffer)
+{
+    // Restore the saved state
+    load(buffer);
+
+    // Propagate the restored warp flag (it is only saved by this component)
+    propagateWarp();
+
+    // Clear the keyboard matrix to avoid constantly pressed keys
+    keyboard.releaseAll();
+    
+    // Inform the GUI
+    messageQueue.put(MSG_SNAPSHOT_RESTORED);
+}
+
 u32
 C64::romCRC32(RomType type)
 {
@@ -1288,9 +1375,8 @@ C64::romSubTitle(u64 fnv)
     
     if (rev != ROM_UNKNOWN) return RomFile::subTitle(rev);
     
-    static char str[32];
-    sprintf(str, "FNV %llx", fnv);
-    return str;
+    snprintf(romSubTitleStr, sizeof(romSubTitleStr), "FNV %llx", fnv);
+    return romSubTitleStr;
 }
 
 const char *
@@ -1417,7 +1503,7 @@ C64::hasMega65Rom(RomType type)
 char *
 C64::mega65BasicRev()
 {
-    static char rev[17];
+    char *rev = mega65BasicRevStr;
     rev[0] = 0;
     
     if (hasMega65Rom(ROM_BASIC)) memcpy(rev, &mem.rom[0xBF55], 16);
@@ -1429,7 +1515,7 @@ C64::mega65BasicRev()
 char *
 C64::mega65KernalRev()
 {
-    static char rev[17];
+    char *rev = mega65KernalRevStr;
     rev[0] = 0;
     
     if (hasMega65Rom(ROM_KERNAL)) memcpy(rev, &mem.rom[0xE4BC], 16);
@@ -1505,7 +1591,9 @@ C64::loadRomFromBuffer(RomType type, const u8 *buffer, size_t length)
         case ROM_BASIC:
         {
             if (RomFile *file = RomFile::makeWithBuffer(buffer, length)) {
-                return loadRom(ROM_BASIC, file);
+                bool result = loadRom(ROM_BASIC, file);
+                delete file;
+                return result;
             }
             msg("Failed to read Basic Rom from buffer\n");
             return false;
@@ -1513,7 +1601,9 @@ C64::loadRomFromBuffer(RomType type, const u8 *buffer, size_t length)
         case ROM_CHAR:
         {
             if (RomFile *file = RomFile::makeWithBuffer(buffer, length)) {
-                return loadRom(ROM_CHAR, file);
+                bool result = loadRom(ROM_CHAR, file);
+                delete file;
+                return result;
             }
             msg("Failed to read Character Rom from buffer\n");
             return false;
@@ -1521,7 +1611,9 @@ C64::loadRomFromBuffer(RomType type, const u8 *buffer, size_t length)
         case ROM_KERNAL:
         {
             if (RomFile *file = RomFile::makeWithBuffer(buffer, length)) {
-                return loadRom(ROM_KERNAL, file);
+                bool result = loadRom(ROM_KERNAL, file);
+                delete file;
+                return result;
             }
             msg("Failed to read Kernal Rom from buffer\n");
             return false;
@@ -1529,7 +1621,9 @@ C64::loadRomFromBuffer(RomType type, const u8 *buffer, size_t length)
         case ROM_VC1541:
         {
             if (RomFile *file = RomFile::makeWithBuffer(buffer, length)) {
-                return loadRom(ROM_VC1541, file);
+                bool result = loadRom(ROM_VC1541, file);
+                delete file;
+                return result;
             }
             msg("Failed to read VC1541 Rom from buffer\n");
             return false;
@@ -1549,7 +1643,9 @@ C64::loadRomFromFile(RomType type, const char *path)
         case ROM_BASIC:
         {
             if (RomFile *file = RomFile::makeWithFile(path)) {
-                return loadRom(ROM_BASIC, file);
+                bool result = loadRom(ROM_BASIC, file);
+                delete file;
+                return result;
             }
             msg("Failed to read Basic Rom from %s\n", path);
             return false;
@@ -1557,7 +1653,9 @@ C64::loadRomFromFile(RomType type, const char *path)
         case ROM_CHAR:
         {
             if (RomFile *file = RomFile::makeWithFile(path)) {
-                return loadRom(ROM_CHAR, file);
+                bool result = loadRom(ROM_CHAR, file);
+                delete file;
+                return result;
             }
             msg("Failed to read Character Rom from %s\n", path);
             return false;
@@ -1565,7 +1663,9 @@ C64::loadRomFromFile(RomType type, const char *path)
         case ROM_KERNAL:
         {
             if (RomFile *file = RomFile::makeWithFile(path)) {
-                return loadRom(ROM_KERNAL, file);
+                bool result = loadRom(ROM_KERNAL, file);
+                delete file;
+                return result;
             }
             msg("Failed to read Kernal Rom from %s\n", path);
             return false;
@@ -1573,7 +1673,9 @@ C64::loadRomFromFile(RomType type, const char *path)
         case ROM_VC1541:
         {
             if (RomFile *file = RomFile::makeWithFile(path)) {
-                return loadRom(ROM_VC1541, file);
+                bool result = loadRom(ROM_VC1541, file);
+                delete file;
+                return result;
             }
             msg("Failed to read VC1541 Rom from %s\n", path);
             return false;
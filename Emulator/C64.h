@@ -23,6 +23,8 @@
 
 // Loading and saving
 #include "Snapshot.h"
+#include "DeltaSnapshot.h"
+#include "RewindBuffer.h"
 #include "T64File.h"
 #include "D64File.h"
 #include "G64File.h"
@@ -77,6 +79,12 @@ class C64 : public HardwareComponent {
     
 public:
     
+    /* Keeps track of the cycles in which the CIAs, the IEC bus, the drives
+     * and the datasette need to be serviced. It is declared first to make
+     * sure it is ready before any component registers an event.
+     */
+    Scheduler scheduler;
+    
     // Core components
     C64Memory mem = C64Memory(*this);
     C64CPU cpu = C64CPU(*this, mem);
@@ -109,6 +117,9 @@ public:
     // Mouse
     Mouse mouse = Mouse(*this);
     
+    // Recorded emulator states for traveling back in time
+    RewindBuffer rewind = RewindBuffer(*this);
+    
     /* Communication channel to the GUI. The GUI registers a listener and a
      * callback function to retrieve messages.
      */
@@ -201,6 +212,11 @@ private:
     Snapshot *autoSnapshot = nullptr;
     Snapshot *userSnapshot = nullptr;
     
+    // Result buffers of romSubTitle(), mega65BasicRev(), mega65KernalRev()
+    char romSubTitleStr[32];
+    char mega65BasicRevStr[17];
+    char mega65KernalRevStr[17];
+    
     //
     // Initializing
     //
@@ -296,6 +312,7 @@ private:
     size_t _size() override { COMPUTE_SNAPSHOT_SIZE }
     size_t _load(u8 *buffer) override { LOAD_SNAPSHOT_ITEMS }
     size_t _save(u8 *buffer) override { SAVE_SNAPSHOT_ITEMS }
+    size_t willSaveToBuffer(u8 *buffer) override;
     
     
     //
@@ -419,13 +436,16 @@ public:
     void executeOneFrame();
     
     /* Emulates the C64 until the end of the current rasterline. This function
-     * is called inside executeOneFrame().
+     * is called inside executeOneFrame(). It runs the debug core of the CPU if
+     * the debugger needs to observe the CPU and the production core otherwise
+     * (see CPU::inDebugCore()).
      */
     void executeOneLine();
+    template <bool dbg> void _executeOneLine();
     
     // Executes a single clock cycle
     void executeOneCycle();
-    void _executeOneCycle();
+    template <bool dbg = false> void _executeOneCycle();
 
     /* Finishes the current instruction. This function is called when the
      * emulator threads terminates in order to reach a clean state. It emulates
@@ -435,6 +455,10 @@ public:
     
 private:
     
+    // Services all due components of the first and second clock phase
+    void executePrimaryEvents(Cycle cycle);
+    void executeSecondaryEvents(Cycle cycle);
+    
     // Invoked before executing the first cycle of a rasterline
     void beginRasterLine();
     
@@ -476,7 +500,13 @@ public:
      */
     void setControlFlags(u32 flags);
     void clearControlFlags(u32 flags);
-    
+
+    /* Returns the pending run loop control flags. Front ends that drive the
+     * emulator via executeOneFrame() without launching the emulator thread
+     * use this function to find out why a frame ended prematurely.
+     */
+    u32 getControlFlags() { return runLoopCtrl; }
+
     // Convenience wrappers for controlling the run loop
     void signalAutoSnapshot() { setControlFlags(RL_AUTO_SNAPSHOT); }
     void signalUserSnapshot() { setControlFlags(RL_USER_SNAPSHOT); }
@@ -526,11 +556,24 @@ public:
     Snapshot *latestAutoSnapshot();
     Snapshot *latestUserSnapshot();
     
+    /* Requests the emulator to travel back in time. The emulator restores the
+     * latest snapshot in the rewind buffer that has been taken in or before
+     * the specified frame. If the emulator is running, the request is
+     * processed by the emulator thread at the end of the current frame.
+     */
+    void requestRewind(u64 frame);
+    
     /* Loads the current state from a snapshot file. This function is not
      * thread-safe and must not be called on a running emulator.
      */
     void loadFromSnapshot(Snapshot *snapshot);
     
+    /* Loads the current state from a buffer that has been written by save().
+     * This function must be called while the emulator is paused or from
+     * within the emulator thread.
+     */
+    void loadFromBuffer(u8 *buffer);
+    
     
     //
     // Handling Roms
@@ -71,6 +71,15 @@ static const int DRV_DEBUG       = 0; // Floppy drive
 static const int TAP_DEBUG       = 0; // Datasette
 static const int KBD_DEBUG       = 0; // Keyboard
 
+//
+// Instrumentation
+//
+
+// Count memory accesses per address and memory type (see MemHeatmap)
+#ifndef MEM_HEATMAP
+#define MEM_HEATMAP 0
+#endif
+
 
 // Default debug level for all components (Set to 1 in release build)
 #define DEBUG_LEVEL 1
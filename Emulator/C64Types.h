@@ -55,6 +55,8 @@ typedef enum : long
     OPT_CUT_OPACITY,
     OPT_SS_COLLISIONS,
     OPT_SB_COLLISIONS,
+    OPT_RENDER_INTERVAL,
+    OPT_FRAMEBUFFER,
 
     // Logic board
     OPT_GLUE_LOGIC,
@@ -79,6 +81,14 @@ typedef enum : long
     OPT_DRIVE_CONNECT,
     OPT_DRIVE_POWER_SWITCH,
     
+    // IEC bus
+    OPT_LAZY_DRIVES,
+    
+    // Rewind buffer
+    OPT_REWIND_BUFFER,
+    OPT_REWIND_INTERVAL,
+    OPT_REWIND_KEYFRAMES,
+    
     // Debugging
     OPT_DEBUGCART
 }
@@ -128,13 +138,14 @@ inline bool isEmulatorState(long value) {
 
 typedef enum
 {
-    RL_STOP               = 0b0000001,
-    RL_CPU_JAMMED         = 0b0000010,
-    RL_INSPECT            = 0b0000100,
-    RL_BREAKPOINT_REACHED = 0b0001000,
-    RL_WATCHPOINT_REACHED = 0b0010000,
-    RL_AUTO_SNAPSHOT      = 0b0100000,
-    RL_USER_SNAPSHOT      = 0b1000000
+    RL_STOP               = 0b00000001,
+    RL_CPU_JAMMED         = 0b00000010,
+    RL_INSPECT            = 0b00000100,
+    RL_BREAKPOINT_REACHED = 0b00001000,
+    RL_WATCHPOINT_REACHED = 0b00010000,
+    RL_AUTO_SNAPSHOT      = 0b00100000,
+    RL_USER_SNAPSHOT      = 0b01000000,
+    RL_REWIND             = 0b10000000
 }
 RunLoopControlFlag;
 
@@ -9,7 +9,7 @@
 
 #include "C64.h"
 
-CIA::CIA(C64 &ref) : C64Component(ref)
+CIA::CIA(EventSlot slot, C64 &ref) : C64Component(ref), eventSlot(slot)
 {
 	setDescription("CIA");
     
@@ -29,6 +29,15 @@ CIA::_reset()
 	
 	latchA = 0xFFFF;
 	latchB = 0xFFFF;
+    
+    scheduler.schedule(eventSlot, wakeUpCycle);
+}
+
+size_t
+CIA::didLoadFromBuffer(u8 *buffer)
+{
+    scheduler.schedule(eventSlot, wakeUpCycle);
+    return 0;
 }
 
 long
@@ -566,6 +575,7 @@ CIA::sleep()
     wakeUpCycle = sleep;
     tiredness = 0;
     sleeping = true;
+    scheduler.schedule(eventSlot, wakeUpCycle);
 }
 
 void
@@ -601,6 +611,7 @@ CIA::wakeUp(Cycle targetCycle)
     }
 
     sleeping = false;
+    scheduler.schedule(eventSlot, wakeUpCycle);
 }
 
 Cycle
@@ -614,7 +625,7 @@ CIA::idleSince()
 // CIA 1
 //
 
-CIA1::CIA1(C64 &ref) : CIA(ref)
+CIA1::CIA1(C64 &ref) : CIA(EVENT_CIA1, ref)
 {
     setDescription("CIA1");
 }
@@ -741,7 +752,7 @@ CIA1::updatePB()
 // CIA 2
 //
 
-CIA2::CIA2(C64 &ref) : CIA(ref)
+CIA2::CIA2(C64 &ref) : CIA(EVENT_CIA2, ref)
 {
     setDescription("CIA2");
 }
@@ -208,6 +208,9 @@ private:
 
     // Total number of skipped cycles (used by the debugger, only)
     Cycle idleCycles;
+    
+    // The scheduler slot holding the wake up cycle
+    EventSlot eventSlot;
         
 public:
     
@@ -231,7 +234,7 @@ public:
     
 public:
     
-	CIA(C64 &ref);
+	CIA(EventSlot slot, C64 &ref);
 
 protected:
     
@@ -318,6 +321,7 @@ private:
     size_t _size() override { COMPUTE_SNAPSHOT_SIZE }
     size_t _load(u8 *buffer) override { LOAD_SNAPSHOT_ITEMS }
     size_t _save(u8 *buffer) override { SAVE_SNAPSHOT_ITEMS }
+    size_t didLoadFromBuffer(u8 *buffer) override;
     
         
     //
@@ -36,6 +36,15 @@ CPU<M>::_reset()
     edgeDetector.clear();
 }
 
+template <typename M> void
+CPU<M>::setProfiling(bool enable)
+{
+    suspend();
+    if (enable && !profiler) profiler = new CPUProfiler();
+    profiling = enable;
+    resume();
+}
+
 template <typename M> void
 CPU<M>::_inspect()
 {    
@@ -58,7 +67,7 @@ template <typename M> void
 CPU<M>::_setDebug(bool enable)
 {
     // We only allow the C64 CPU to run in debug mode
-    if (isC64CPU()) { debugMode = enable; }
+    if constexpr (isC64) { debugMode = enable || debugger.isTracing(); }
 }
 
 template <typename M> void
@@ -196,6 +205,7 @@ DriveCPU::DriveCPU(C64& ref, DriveMemory &memref) : CPU(ref, memref)
 template         CPU<C64Memory>::CPU(C64& ref, C64Memory& memref);
 template CPUInfo CPU<C64Memory>::getInfo();
 template void    CPU<C64Memory>::_dump();
+template void    CPU<C64Memory>::setProfiling(bool enable);
 template void    CPU<C64Memory>::_setDebug(bool enable);
 template void    CPU<C64Memory>::_reset();
 template void    CPU<C64Memory>::_inspect();
@@ -212,6 +222,7 @@ template void    CPU<C64Memory>::setRDY(bool value);
 template         CPU<DriveMemory>::CPU(C64& ref, DriveMemory& memref);
 template CPUInfo CPU<DriveMemory>::getInfo();
 template void    CPU<DriveMemory>::_dump();
+template void    CPU<DriveMemory>::setProfiling(bool enable);
 template void    CPU<DriveMemory>::_setDebug(bool enable);
 template void    CPU<DriveMemory>::_reset();
 template void    CPU<DriveMemory>::_inspect();
@@ -13,10 +13,12 @@
 #include "C64Component.h"
 #include "CPUDebugger.h"
 #include "CPUInstructions.h"
+#include "CPUProfiler.h"
 #include "ProcessorPort.h"
 #include "TimeDelayed.h"
 
 class Memory;
+class C64Memory;
 
 template <typename MEMTYPE>
 class CPU : public C64Component {
@@ -62,6 +64,13 @@ public:
     virtual bool isC64CPU() = 0;
     virtual bool isDriveCPU() = 0;
 
+    /* Indicates if this CPU is connected to the C64 memory. In contrast to
+     * isC64CPU(), the value is known at compile time. It is used to strip
+     * off all C64 specific code (debugger hooks, expansion port callbacks)
+     * from the drive CPU instantiation.
+     */
+    static constexpr bool isC64 = std::is_same<MEMTYPE, C64Memory>::value;
+
     
     //
     // Lookup tables
@@ -84,10 +93,19 @@ protected:
      * In debug mode, the CPU checks for breakpoints and records executed
      * instruction in the log buffer.
      */
-    bool debugMode;
+    bool debugMode = false;
+    
+    // Indicates if memory accesses are checked against the watchpoints
+    bool checkWatchpoints = false;
     
 public:
     
+    // Execution profiler (created when profiling is enabled for the first time)
+    CPUProfiler *profiler = nullptr;
+    
+    // Indicates if the profiler is running
+    bool profiling = false;
+    
     // Elapsed clock cycles since power up
     u64 cycle;
                         
@@ -193,6 +211,7 @@ private:
 public:
     
     CPU(C64& ref, MEMTYPE& memref);
+    ~CPU() { delete profiler; }
     
 private:
     
@@ -397,13 +416,27 @@ public:
     // Returns true if the next cycle marks the beginning of an instruction
     bool inFetchPhase() { return next == fetch; }
 
+    /* Returns true if the debug core needs to be executed. The CPU core is
+     * instantiated twice. The debug core records executed instructions,
+     * checks for breakpoints and watchpoints, and feeds the profiler. In the
+     * production core, all of these hooks are compiled out. The C64 selects
+     * the core to run at the beginning of each rasterline. The drive CPUs
+     * only run the debug core while they are profiled.
+     */
+    bool inDebugCore() { return debugMode || checkWatchpoints || profiling; }
+    
+    /* Starts or stops the profiler (see CPUProfiler.h). The recorded data is
+     * kept when the profiler is stopped.
+     */
+    void setProfiling(bool enable);
+    
     // Executes the next micro instruction
-    void executeOneCycle();
+    template <bool dbg = false> void executeOneCycle();
 
 private:
 
     // Called after the last microcycle has been completed
-    void done();
+    template <bool dbg> void done();
 };
 
 
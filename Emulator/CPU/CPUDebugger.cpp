@@ -24,6 +24,15 @@ Guard::eval(u32 addr)
     return false;
 }
 
+bool
+Guard::eval(u32 addr, WatchAccess access, u8 value)
+{
+    if (!(this->access & access)) return false;
+    if ((value & mask) != this->value) return false;
+    
+    return eval(addr);
+}
+
 //
 // Guards
 //
@@ -37,6 +46,8 @@ Guards::guardWithNr(long nr)
 Guard *
 Guards::guardAtAddr(u32 addr)
 {
+    if (!isMarked(addr)) return NULL;
+    
     for (int i = 0; i < count; i++) {
         if (guards[i].addr == addr) return &guards[i];
     }
@@ -79,7 +90,7 @@ Guards::isSetAndConditionalAt(u32 addr)
 void
 Guards::addAt(u32 addr, long skip)
 {
-    if (isSetAt(addr)) return;
+    if (addr > 0xFFFF || isSetAt(addr)) return;
 
     if (count >= capacity) {
 
@@ -94,7 +105,11 @@ Guards::addAt(u32 addr, long skip)
     guards[count].enabled = true;
     guards[count].hits = 0;
     guards[count].skip = skip;
+    guards[count].access = WATCH_ANY;
+    guards[count].mask = 0;
+    guards[count].value = 0;
     count++;
+    mark(addr, true);
     setNeedsCheck(true);
 }
 
@@ -113,19 +128,46 @@ Guards::removeAt(u32 addr)
 
             for (int j = i; j + 1 < count; j++) guards[j] = guards[j + 1];
             count--;
+            mark(addr, false);
             break;
         }
     }
     setNeedsCheck(count != 0);
 }
 
+void
+Guards::removeAll()
+{
+    count = 0;
+    memset(bitmap, 0, sizeof(bitmap));
+    setNeedsCheck(false);
+}
+
 void
 Guards::replace(long nr, u32 addr)
 {
-    if (nr >= count || isSetAt(addr)) return;
+    if (nr >= count || addr > 0xFFFF || isSetAt(addr)) return;
     
+    mark(guards[nr].addr, false);
     guards[nr].addr = addr;
     guards[nr].hits = 0;
+    mark(addr, true);
+}
+
+void
+Guards::setAccess(long nr, WatchAccess access)
+{
+    assert(isWatchAccess(access));
+    if (nr < count) guards[nr].access = access;
+}
+
+void
+Guards::setCondition(long nr, u8 mask, u8 value)
+{
+    if (nr < count) {
+        guards[nr].mask = mask;
+        guards[nr].value = value & mask;
+    }
 }
 
 bool
@@ -147,19 +189,32 @@ Guards::setEnableAt(u32 addr, bool value)
     if (guard) guard->enabled = value;
 }
 
-bool
-Guards::eval(u32 addr)
+void
+Guards::mark(u32 addr, bool value)
 {
-    for (int i = 0; i < count; i++)
-        if (guards[i].eval(addr)) return true;
+    assert(addr <= 0xFFFF);
+    
+    u32 mask = 1 << (addr & 31);
+    
+    if (value) {
+        bitmap[(addr & 0xFFFF) >> 5] |= mask;
+    } else {
+        bitmap[(addr & 0xFFFF) >> 5] &= ~mask;
+    }
+}
 
-    return false;
+bool
+Guards::evalGuardAt(u32 addr)
+{
+    Guard *guard = guardAtAddr(addr);
+    
+    return guard != NULL && guard->eval(addr);
 }
 
 void
 Breakpoints::setNeedsCheck(bool value)
 {
-    if (value || cpu.c64.inDebugMode()) {
+    if (value || cpu.c64.inDebugMode() || cpu.debugger.isTracing()) {
         cpu.debugMode = true;
     } else {
         cpu.debugMode = false;
@@ -169,7 +224,21 @@ Breakpoints::setNeedsCheck(bool value)
 void
 Watchpoints::setNeedsCheck(bool value)
 {
-    cpu.c64.mem.checkWatchpoints = value;
+    cpu.checkWatchpoints = value;
+}
+
+bool
+Watchpoints::evalReadAt(u32 addr)
+{
+    return evalAt(addr, WATCH_READ, cpu.c64.mem.spypeek((u16)addr));
+}
+
+bool
+Watchpoints::evalAt(u32 addr, WatchAccess access, u8 value)
+{
+    Guard *guard = guardAtAddr(addr);
+    
+    return guard != NULL && guard->eval(addr, access, value);
 }
 
 //
@@ -181,6 +250,11 @@ CPUDebugger::CPUDebugger(C64 &ref) : C64Component(ref)
     setDescription("CPU Debugger");
 }
 
+CPUDebugger::~CPUDebugger()
+{
+    delete trace;
+}
+
 void
 CPUDebugger::registerInstruction(u8 opcode, const char *mnemonic, AddressingMode mode)
 {
@@ -214,25 +288,13 @@ CPUDebugger::setSoftStop(u64 addr)
 }
 
 bool
-CPUDebugger::breakpointMatches(u32 addr)
+CPUDebugger::softStopMatches()
 {
-    // Check if a soft breakpoint has been reached
-    if (addr == softStop || softStop == UINT64_MAX) {
-
-        // Soft breakpoints are deleted when reached
-        softStop = UINT64_MAX - 1;
-        breakpoints.setNeedsCheck(breakpoints.elements() != 0);
-
-        return true;
-    }
-
-    return breakpoints.eval(addr);
-}
+    // Soft breakpoints are deleted when reached
+    softStop = UINT64_MAX - 1;
+    breakpoints.setNeedsCheck(breakpoints.elements() != 0);
 
-bool
-CPUDebugger::watchpointMatches(u32 addr)
-{
-    return watchpoints.eval(addr);
+    return true;
 }
 
 int
@@ -260,6 +322,55 @@ CPUDebugger::logInstruction()
     logBuffer[i].x = cpu.reg.x;
     logBuffer[i].y = cpu.reg.y;
     logBuffer[i].flags = cpu.getP();
+    
+    if (trace) trace->write(logBuffer[i]);
+}
+
+bool
+CPUDebugger::startTrace(const char *path)
+{
+    u8 lengths[256];
+    getInstructionLengths(lengths);
+    TraceWriter *writer = new TraceWriter(lengths);
+    
+    if (!writer->open(path)) {
+        warn("Cannot create trace file %s\n", path);
+        delete writer;
+        return false;
+    }
+    
+    suspend();
+    delete trace;
+    trace = writer;
+    breakpoints.setNeedsCheck(breakpoints.elements() != 0);
+    resume();
+    
+    return true;
+}
+
+bool
+CPUDebugger::stopTrace()
+{
+    bool success = true;
+    
+    suspend();
+    if (trace) {
+        trace->close();
+        success = !trace->hasFailed();
+        delete trace;
+        trace = nullptr;
+    }
+    breakpoints.setNeedsCheck(breakpoints.elements() != 0);
+    resume();
+    
+    if (!success) warn("Failed to write the instruction trace\n");
+    return success;
+}
+
+void
+CPUDebugger::getInstructionLengths(u8 *lengths)
+{
+    for (unsigned i = 0; i < 256; i++) lengths[i] = getLengthOfInstruction((u8)i);
 }
 
 RecordedInstruction &
@@ -385,7 +496,7 @@ CPUDebugger::disassembleBytes(u16 addr)
 const char *
 CPUDebugger::disassembleAddr(u16 addr)
 {
-    static char result[6];
+    char *result = addrStr;
 
     hex ? sprint16x(result, addr) : sprint16d(result, addr);
     return result;
@@ -412,7 +523,7 @@ CPUDebugger::disassemblePC()
 const char *
 CPUDebugger::disassembleInstr(RecordedInstruction &instr, long *len)
 {
-    static char result[16];
+    char *result = instrStr;
         
     u8 opcode = instr.byte1;
     if (len) *len = getLengthOfInstruction(opcode);
@@ -512,7 +623,7 @@ CPUDebugger::disassembleInstr(RecordedInstruction &instr, long *len)
 const char *
 CPUDebugger::disassembleBytes(RecordedInstruction &instr)
 {
-    static char result[13]; char *ptr = result;
+    char *result = bytesStr; char *ptr = result;
     
     int len = getLengthOfInstruction(instr.byte1);
     
@@ -533,7 +644,7 @@ CPUDebugger::disassembleBytes(RecordedInstruction &instr)
 const char *
 CPUDebugger::disassembleRecordedFlags(RecordedInstruction &instr)
 {
-    static char result[9];
+    char *result = flagsStr;
     
     result[0] = (instr.flags & N_FLAG) ? 'N' : 'n';
     result[1] = (instr.flags & V_FLAG) ? 'V' : 'v';
@@ -11,6 +11,7 @@
 #define _CPU_DEBUGGER_H
 
 #include "C64Component.h"
+#include "CPUTrace.h"
 
 // Base structure for a single breakpoint or watchpoint
 struct Guard {
@@ -27,10 +28,21 @@ struct Guard {
     // Number of skipped hits before a match is signalled
     long skip;
     
+    // Memory accesses observed by a watchpoint
+    WatchAccess access;
+    
+    /* Value condition of a watchpoint. A watchpoint only hits if the accessed
+     * value v satisfies (v & mask) == value. The default mask of 0 matches
+     * all values.
+     */
+    u8 mask;
+    u8 value;
+    
 public:
     
     // Returns true if the guard hits
     bool eval(u32 addr);
+    bool eval(u32 addr, WatchAccess access, u8 value);
 };
 
 // Base class for a collection of guards
@@ -40,7 +52,7 @@ class Guards {
 
 public:
     
-    virtual ~Guards() { };
+    virtual ~Guards() { delete [] guards; }
     
 protected:
 
@@ -56,6 +68,12 @@ protected:
     // Number of currently stored guards
     long count = 0;
 
+    /* Address bitmap. A bit is set iff a guard (enabled or disabled) is set at
+     * the corresponding address. It allows to reject almost all addresses
+     * with a single bit test, independent of the number of guards.
+     */
+    u32 bitmap[0x10000 / 32] = { };
+
     // Indicates if guard checking is necessary
     virtual void setNeedsCheck(bool value) = 0;
     
@@ -88,14 +106,22 @@ public:
     // Adding or removing guards
     //
     
+    // Guards can only be set inside the 64KB address space
     void addAt(u32 addr, long skip = 0);
     void removeAt(u32 addr);
     
     void remove(long nr);
-    void removeAll() { count = 0; setNeedsCheck(false); }
+    void removeAll();
     
     void replace(long nr, u32 addr);
     
+    //
+    // Adding conditions (watchpoints only)
+    //
+    
+    void setAccess(long nr, WatchAccess access);
+    void setCondition(long nr, u8 mask, u8 value);
+    
     //
     // Enabling or disabling guards
     //
@@ -115,9 +141,17 @@ public:
     // Checking a guard
     //
     
-private:
+protected:
     
-    bool eval(u32 addr);
+    // Returns true if a guard is set at the specified address
+    bool isMarked(u32 addr) { return bitmap[(addr & 0xFFFF) >> 5] >> (addr & 31) & 1; }
+
+    // Sets or clears the bit of the specified address in the bitmap
+    void mark(u32 addr, bool value);
+    
+    // Returns true if a guard hits
+    bool eval(u32 addr) { return isMarked(addr) && evalGuardAt(addr); }
+    bool evalGuardAt(u32 addr);
 };
 
 class Breakpoints : public Guards {
@@ -134,6 +168,17 @@ public:
     
     Watchpoints(CPU<C64Memory>& ref) : Guards(ref) { }
     void setNeedsCheck(bool value) override;
+    
+    /* Returns true if a watchpoint hits. The read check is performed before
+     * the memory is accessed. The compared value is obtained via spypeek().
+     */
+    bool evalRead(u32 addr) { return isMarked(addr) && evalReadAt(addr); }
+    bool evalWrite(u32 addr, u8 value) { return isMarked(addr) && evalAt(addr, WATCH_WRITE, value); }
+    
+private:
+    
+    bool evalReadAt(u32 addr);
+    bool evalAt(u32 addr, WatchAccess access, u8 value);
 };
 
 class CPUDebugger : public C64Component {
@@ -154,7 +199,7 @@ public:
     // Breakpoint storage
     Breakpoints breakpoints = Breakpoints(cpu);
 
-    // Watchpoint storage (not yet supported)
+    // Watchpoint storage
     Watchpoints watchpoints = Watchpoints(cpu);
     
 private:
@@ -175,6 +220,17 @@ private:
      * UINT64_MAX - 1.
      */
     u64 softStop = UINT64_MAX - 1;
+
+    // Instruction trace (nullptr if no trace is recorded)
+    TraceWriter *trace = nullptr;
+    
+    /* Result buffers of the disassembler. The returned strings stay valid
+     * until the same function is called again on the same debugger.
+     */
+    char addrStr[6];
+    char instrStr[16];
+    char bytesStr[13];
+    char flagsStr[9];
         
 public:
     
@@ -189,6 +245,7 @@ public:
 public:
     
     CPUDebugger(C64 &ref);
+    ~CPUDebugger();
 
     // Initializes an entry of the lookup tables
     void registerInstruction(u8 opcode, const char *mnemonic, AddressingMode mode);
@@ -239,10 +296,20 @@ public:
     void setSoftStopAtNextInstr() { setSoftStop(getAddressOfNextInstruction()); }
     
     // Returns true if a breakpoint hits at the provides address
-    bool breakpointMatches(u32 addr);
+    bool breakpointMatches(u32 addr) {
+        return unlikely(addr == softStop || softStop == UINT64_MAX) ?
+        softStopMatches() : breakpoints.eval(addr); }
 
     // Returns true if a watchpoint hits at the provides address
-    bool watchpointMatches(u32 addr);
+    bool readWatchpointMatches(u32 addr) { return watchpoints.evalRead(addr); }
+    bool writeWatchpointMatches(u32 addr, u8 value) { return watchpoints.evalWrite(addr, value); }
+    
+private:
+    
+    // Deletes the soft breakpoint when it has been reached
+    bool softStopMatches();
+    
+public:
     
     
     //
@@ -268,6 +335,25 @@ public:
     // Clears the log buffer
     void clearLog() { logCnt = 0; }
     
+    //
+    // Recording an instruction trace
+    //
+    
+    /* Starts streaming all executed instructions to a trace file (see
+     * CPUTrace.h). While a trace is recorded, the CPU runs in debug mode.
+     * stopTrace() closes the file and returns false if the trace could not
+     * be written completely.
+     */
+    bool startTrace(const char *path);
+    bool stopTrace();
+    bool isTracing() { return trace != nullptr; }
+    
+    // Returns the number of traced instructions
+    u64 tracedInstructions() { return trace ? trace->count() : 0; }
+    
+    // Returns the length of each instruction, indexed by opcode
+    void getInstructionLengths(u8 *lengths);
+    
     //
     // Examining instructions
     //
@@ -300,8 +386,7 @@ public:
     const char *disassembleDataBytes();
     const char *disassemblePC();
 
-private:
-    
+    // Disassembles an instruction record (e.g., read from a trace file)
     const char *disassembleInstr(RecordedInstruction &instr, long *len);
     const char *disassembleBytes(RecordedInstruction &instr);
     const char *disassembleRecordedFlags(RecordedInstruction &instr);
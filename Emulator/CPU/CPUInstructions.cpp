@@ -439,11 +439,15 @@ CPU<M>::registerIllegalInstructions()
     registerCallback(0x9B, "TAS*", ADDR_ABSOLUTE_Y, TAS_abs_y);
 }
 
-template <typename M> void
+template <typename M> template <bool dbg> void
 CPU<M>::executeOneCycle()
 {
     u8 instr;
     
+    if constexpr (dbg) {
+        if (profiling) profiler->countCycle(reg.pc0, next, rdyLine);
+    }
+    
     switch (next) {
             
         case fetch:
@@ -451,7 +455,7 @@ CPU<M>::executeOneCycle()
             // Check interrupt lines
             if (unlikely(doNmi)) {
                 
-                if (isC64CPU()) {
+                if constexpr (isC64) {
                     expansionport.nmiWillTrigger();
                 }
                 
@@ -521,6 +525,7 @@ CPU<M>::executeOneCycle()
             
         case irq_5:
             
+            WATCH_W(0x100 + reg.sp, getPWithClearedB())
             mem.poke(0x100+(reg.sp--), getPWithClearedB());
             CONTINUE
             
@@ -535,6 +540,7 @@ CPU<M>::executeOneCycle()
             
             READ_FROM(0xFFFF)
             setPCH(reg.d);
+            PROFILE_CALL(3)
             DONE
             
         //
@@ -558,6 +564,7 @@ CPU<M>::executeOneCycle()
             
         case nmi_5:
             
+            WATCH_W(0x100 + reg.sp, getPWithClearedB())
             mem.poke(0x100+(reg.sp--), getPWithClearedB());
             CONTINUE
             
@@ -573,9 +580,10 @@ CPU<M>::executeOneCycle()
             READ_FROM(0xFFFB)
             setPCH(reg.d);
             
-            if (isC64CPU()) {
+            if constexpr (isC64) {
                 expansionport.nmiDidTrigger();
             }
+            PROFILE_CALL(3)
             DONE
 
         //
@@ -1222,6 +1230,7 @@ CPU<M>::executeOneCycle()
             doNmi = false; // Only the level detector is polled here. This is
                            // the reason why only IRQs can be triggered right
                            // after a BRK command, but not NMIs.
+            PROFILE_CALL(3)
             DONE
             
         case BRK_nmi_4:
@@ -1241,6 +1250,7 @@ CPU<M>::executeOneCycle()
             READ_FROM(0xFFFB);
             setPCH(reg.d);
             POLL_INT
+            PROFILE_CALL(3)
             DONE
 
             
@@ -1714,6 +1724,7 @@ CPU<M>::executeOneCycle()
             FETCH_ADDR_HI
             reg.pc = LO_HI(reg.adl, reg.adh);
             POLL_INT
+            PROFILE_CALL(2)
             DONE
 
             
@@ -2195,6 +2206,7 @@ CPU<M>::executeOneCycle()
             
             PULL_PCH
             POLL_INT
+            PROFILE_RETURN
             DONE
 
 
@@ -2226,6 +2238,7 @@ CPU<M>::executeOneCycle()
             
             IDLE_READ_IMMEDIATE
             POLL_INT
+            PROFILE_RETURN
             DONE
 
             
@@ -3177,31 +3190,37 @@ CPU<M>::executeOneCycle()
     }
 }
 
-template <> void CPU<C64Memory>::done() {
-
-    if (debugMode) {
-
-        // Record the instruction
-        debugger.logInstruction();
-    
-        // Check if a breakpoint has been reached
-        if (debugger.breakpointMatches(reg.pc)) c64.signalBreakpoint();
+template <typename M> template <bool dbg> void
+CPU<M>::done()
+{
+    if constexpr (dbg) {
+        
+        // The drive CPUs are never debugged
+        if (isC64 && debugMode) {
+            
+            // Record the instruction
+            debugger.logInstruction();
+            
+            // Check if a breakpoint has been reached
+            if (debugger.breakpointMatches(reg.pc)) c64.signalBreakpoint();
+        }
+        
+        // Feed the profiler (interrupt sequences are no instructions)
+        if (profiling && next != irq_7 && next != nmi_7) {
+            profiler->countInstruction(reg.pc0);
+        }
     }
     
     reg.pc0 = reg.pc;
     next = fetch;
 }
 
-template <> void CPU<DriveMemory>::done() {
-    
-    reg.pc0 = reg.pc;
-    next = fetch;
-}
-
 
 void done();
 
 template void CPU<C64Memory>::registerInstructions();
-template void CPU<C64Memory>::executeOneCycle();
+template void CPU<C64Memory>::executeOneCycle<false>();
+template void CPU<C64Memory>::executeOneCycle<true>();
 template void CPU<DriveMemory>::registerInstructions();
-template void CPU<DriveMemory>::executeOneCycle();
+template void CPU<DriveMemory>::executeOneCycle<false>();
+template void CPU<DriveMemory>::executeOneCycle<true>();
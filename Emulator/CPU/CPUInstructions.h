@@ -314,73 +314,103 @@ typedef enum {
 // void loadX(u8 x) { reg.x = x; setN(x & 0x80); setZ(x == 0); }
 // void loadY(u8 y) { reg.y = y; setN(y & 0x80); setZ(y == 0); }
 
+/* The RDY line is only pulled down by VICII. In the drives, it is always high
+ * and the corresponding checks are compiled out.
+ */
+#define RDY_HIGH (!isC64 || rdyLine)
+
+/* In the debug core, each memory access is checked against the watchpoints.
+ * In the production core, the check is compiled out.
+ */
+#define WATCH_R(addr) \
+if constexpr (dbg) { \
+if (checkWatchpoints && debugger.readWatchpointMatches(addr)) c64.signalWatchpoint(); }
+#define WATCH_W(addr,value) \
+if constexpr (dbg) { \
+if (checkWatchpoints && debugger.writeWatchpointMatches(addr, value)) c64.signalWatchpoint(); }
+
+/* Profiler hooks of the debug core. A call passes the value of the stack
+ * pointer after the matching return (JSR pushes two bytes, BRK and the
+ * interrupt sequences push three).
+ */
+#define PROFILE_CALL(bytes) \
+if constexpr (dbg) { if (profiling) profiler->call(reg.pc, (u8)(reg.sp + bytes), cycle); }
+#define PROFILE_RETURN \
+if constexpr (dbg) { if (profiling) profiler->ret(reg.sp, cycle); }
+
+/* If the memory heatmap is compiled in, opcode fetches of the C64 CPU are
+ * counted as executions (see MemHeatmap).
+ */
+#define COUNT_EXEC \
+if constexpr (isC64 && MEM_HEATMAP) { mem.countAccess(HEAT_EXEC, reg.pc, mem.getPeekSource(reg.pc)); }
+
 // Atomic CPU tasks
 #define FETCH_OPCODE \
-if (likely(rdyLine)) instr = mem.peek(reg.pc++); else return;
+if (likely(RDY_HIGH)) { WATCH_R(reg.pc) COUNT_EXEC instr = mem.peek(reg.pc++); } else return;
 #define FETCH_ADDR_LO \
-if (likely(rdyLine)) reg.adl = mem.peek(reg.pc++); else return;
+if (likely(RDY_HIGH)) { WATCH_R(reg.pc) reg.adl = mem.peek(reg.pc++); } else return;
 #define FETCH_ADDR_HI \
-if (likely(rdyLine)) reg.adh = mem.peek(reg.pc++); else return;
+if (likely(RDY_HIGH)) { WATCH_R(reg.pc) reg.adh = mem.peek(reg.pc++); } else return;
 #define FETCH_POINTER_ADDR \
-if (likely(rdyLine)) reg.idl = mem.peek(reg.pc++); else return;
+if (likely(RDY_HIGH)) { WATCH_R(reg.pc) reg.idl = mem.peek(reg.pc++); } else return;
 #define FETCH_ADDR_LO_INDIRECT \
-if (likely(rdyLine)) reg.adl = mem.peek((u16)reg.idl++); else return;
+if (likely(RDY_HIGH)) { WATCH_R(reg.idl) reg.adl = mem.peek((u16)reg.idl++); } else return;
 #define FETCH_ADDR_HI_INDIRECT \
-if (likely(rdyLine)) reg.adh = mem.peek((u16)reg.idl++); else return;
+if (likely(RDY_HIGH)) { WATCH_R(reg.idl) reg.adh = mem.peek((u16)reg.idl++); } else return;
 #define IDLE_FETCH \
-if (likely(rdyLine)) mem.peekIdle(reg.pc); else return;
+if (likely(RDY_HIGH)) { WATCH_R(reg.pc) mem.peekIdle(reg.pc); } else return;
 
 
 #define READ_RELATIVE \
-if (likely(rdyLine)) reg.d = mem.peek(reg.pc); else return;
+if (likely(RDY_HIGH)) { WATCH_R(reg.pc) reg.d = mem.peek(reg.pc); } else return;
 #define READ_IMMEDIATE \
-if (likely(rdyLine)) reg.d = mem.peek(reg.pc++); else return;
+if (likely(RDY_HIGH)) { WATCH_R(reg.pc) reg.d = mem.peek(reg.pc++); } else return;
 #define READ_FROM(x) \
-if (likely(rdyLine)) reg.d = mem.peek(x); else return;
+if (likely(RDY_HIGH)) { WATCH_R(x) reg.d = mem.peek(x); } else return;
 #define READ_FROM_ADDRESS \
-if (likely(rdyLine)) reg.d = mem.peek(HI_LO(reg.adh, reg.adl)); else return;
+if (likely(RDY_HIGH)) { WATCH_R(HI_LO(reg.adh, reg.adl)) reg.d = mem.peek(HI_LO(reg.adh, reg.adl)); } else return;
 #define READ_FROM_ZERO_PAGE \
-if (likely(rdyLine)) reg.d = mem.peekZP(reg.adl); else return;
+if (likely(RDY_HIGH)) { WATCH_R(reg.adl) reg.d = mem.peekZP(reg.adl); } else return;
 #define READ_FROM_ADDRESS_INDIRECT \
-if (likely(rdyLine)) reg.d = mem.peekZP(reg.dl); else return;
+if (likely(RDY_HIGH)) { WATCH_R(reg.dl) reg.d = mem.peekZP(reg.dl); } else return;
 
 #define IDLE_READ_IMPLIED \
-if (likely(rdyLine)) mem.peekIdle(reg.pc); else return;
+if (likely(RDY_HIGH)) { WATCH_R(reg.pc) mem.peekIdle(reg.pc); } else return;
 #define IDLE_READ_IMMEDIATE \
-if (likely(rdyLine)) mem.peekIdle(reg.pc++); else return;
+if (likely(RDY_HIGH)) { WATCH_R(reg.pc) mem.peekIdle(reg.pc++); } else return;
 #define IDLE_READ_FROM(x) \
-if (likely(rdyLine)) mem.peekIdle(x); else return;
+if (likely(RDY_HIGH)) { WATCH_R(x) mem.peekIdle(x); } else return;
 #define IDLE_READ_FROM_ADDRESS \
-if (likely(rdyLine)) mem.peekIdle(HI_LO(reg.adh, reg.adl)); else return;
+if (likely(RDY_HIGH)) { WATCH_R(HI_LO(reg.adh, reg.adl)) mem.peekIdle(HI_LO(reg.adh, reg.adl)); } else return;
 #define IDLE_READ_FROM_ZERO_PAGE \
-if (likely(rdyLine)) mem.peekZPIdle(reg.adl); else return;
+if (likely(RDY_HIGH)) { WATCH_R(reg.adl) mem.peekZPIdle(reg.adl); } else return;
 #define IDLE_READ_FROM_ADDRESS_INDIRECT \
-if (likely(rdyLine)) mem.peekZPIdle(reg.idl); else return;
+if (likely(RDY_HIGH)) { WATCH_R(reg.idl) mem.peekZPIdle(reg.idl); } else return;
 
 #define WRITE_TO_ADDRESS \
-mem.poke(HI_LO(reg.adh, reg.adl), reg.d);
+WATCH_W(HI_LO(reg.adh, reg.adl), reg.d) mem.poke(HI_LO(reg.adh, reg.adl), reg.d);
 #define WRITE_TO_ADDRESS_AND_SET_FLAGS \
-mem.poke(HI_LO(reg.adh, reg.adl), reg.d); setN(reg.d & 0x80); setZ(reg.d == 0);
+WATCH_W(HI_LO(reg.adh, reg.adl), reg.d) mem.poke(HI_LO(reg.adh, reg.adl), reg.d); setN(reg.d & 0x80); setZ(reg.d == 0);
 #define WRITE_TO_ZERO_PAGE \
-mem.pokeZP(reg.adl, reg.d);
+WATCH_W(reg.adl, reg.d) mem.pokeZP(reg.adl, reg.d);
 #define WRITE_TO_ZERO_PAGE_AND_SET_FLAGS \
-mem.pokeZP(reg.adl, reg.d); setN(reg.d & 0x80); setZ(reg.d == 0);
+WATCH_W(reg.adl, reg.d) mem.pokeZP(reg.adl, reg.d); setN(reg.d & 0x80); setZ(reg.d == 0);
 
 #define ADD_INDEX_X reg.ovl = ((int)reg.adl + (int)reg.x > 0xFF); reg.adl += reg.x;
 #define ADD_INDEX_Y reg.ovl = ((int)reg.adl + (int)reg.y > 0xFF); reg.adl += reg.y;
 #define ADD_INDEX_X_INDIRECT reg.idl += reg.x;
 #define ADD_INDEX_Y_INDIRECT reg.idl += reg.y;
 
-#define PUSH_PCL mem.pokeStack(reg.sp--, LO_BYTE(reg.pc));
-#define PUSH_PCH mem.pokeStack(reg.sp--, HI_BYTE(reg.pc));
-#define PUSH_P mem.pokeStack(reg.sp--, getP());
-#define PUSH_P_WITH_B_SET mem.pokeStack(reg.sp--, getP() | B_FLAG);
-#define PUSH_A mem.pokeStack(reg.sp--, reg.a);
-#define PULL_PCL if (likely(rdyLine)) { setPCL(mem.peekStack(reg.sp)); } else return;
-#define PULL_PCH if (likely(rdyLine)) { setPCH(mem.peekStack(reg.sp)); } else return;
-#define PULL_P if (likely(rdyLine)) { setPWithoutB(mem.peekStack(reg.sp)); } else return;
-#define PULL_A if (likely(rdyLine)) { loadA(mem.peekStack(reg.sp)); } else return;
-#define IDLE_PULL if (likely(rdyLine)) { mem.peekStackIdle(reg.sp); } else return;
+#define PUSH_PCL WATCH_W(0x100 + reg.sp, LO_BYTE(reg.pc)) mem.pokeStack(reg.sp--, LO_BYTE(reg.pc));
+#define PUSH_PCH WATCH_W(0x100 + reg.sp, HI_BYTE(reg.pc)) mem.pokeStack(reg.sp--, HI_BYTE(reg.pc));
+#define PUSH_P WATCH_W(0x100 + reg.sp, getP()) mem.pokeStack(reg.sp--, getP());
+#define PUSH_P_WITH_B_SET WATCH_W(0x100 + reg.sp, getP() | B_FLAG) mem.pokeStack(reg.sp--, getP() | B_FLAG);
+#define PUSH_A WATCH_W(0x100 + reg.sp, reg.a) mem.pokeStack(reg.sp--, reg.a);
+#define PULL_PCL if (likely(RDY_HIGH)) { WATCH_R(0x100 + reg.sp) setPCL(mem.peekStack(reg.sp)); } else return;
+#define PULL_PCH if (likely(RDY_HIGH)) { WATCH_R(0x100 + reg.sp) setPCH(mem.peekStack(reg.sp)); } else return;
+#define PULL_P if (likely(RDY_HIGH)) { WATCH_R(0x100 + reg.sp) setPWithoutB(mem.peekStack(reg.sp)); } else return;
+#define PULL_A if (likely(RDY_HIGH)) { WATCH_R(0x100 + reg.sp) loadA(mem.peekStack(reg.sp)); } else return;
+#define IDLE_PULL if (likely(RDY_HIGH)) { WATCH_R(0x100 + reg.sp) mem.peekStackIdle(reg.sp); } else return;
 
 #define PAGE_BOUNDARY_CROSSED reg.ovl
 #define FIX_ADDR_HI reg.adh++;
@@ -391,6 +421,6 @@ mem.pokeZP(reg.adl, reg.d); setN(reg.d & 0x80); setZ(reg.d == 0);
 #define POLL_INT_AGAIN doIrq |= (levelDetector.delayed() && !getI()); \
                        doNmi |= edgeDetector.delayed();
 #define CONTINUE next = (MicroInstruction)((int)next+1); return;
-#define DONE     done(); return;
+#define DONE     done<dbg>(); return;
 
 #endif
@@ -0,0 +1,117 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "C64.h"
+
+#include <algorithm>
+
+void
+CPUProfiler::clear()
+{
+    memset(instructions, 0, sizeof(instructions));
+    memset(cycles, 0, sizeof(cycles));
+    memset(stalls, 0, sizeof(stalls));
+
+    edges.clear();
+    stack.clear();
+    prevNext = -1;
+    prevRdy = true;
+}
+
+void
+CPUProfiler::call(u16 target, u8 sp, u64 cycle)
+{
+    /* Close all frames that have been left without return. The stack grows
+     * downwards, so the return address of a frame with the same or a lower
+     * stack pointer has already been overwritten.
+     */
+    while (!stack.empty() && stack.back().sp <= sp) close(cycle);
+    
+    u32 caller = stack.empty() ? root : stack.back().callee;
+
+    stack.push_back(Frame { caller, target, sp, cycle });
+    edges[(u64)caller << 32 | target].calls++;
+}
+
+void
+CPUProfiler::ret(u8 sp, u64 cycle)
+{
+    // Find the frame this instruction returns from
+    size_t depth = stack.size();
+    while (depth > 0 && stack[depth - 1].sp != sp) depth--;
+
+    // Ignore the instruction if it doesn't return from a call (e.g., RTS jumps)
+    if (depth == 0) return;
+
+    // Close the frame and all nested frames that have been left without return
+    while (stack.size() >= depth) close(cycle);
+}
+
+void
+CPUProfiler::close(u64 cycle)
+{
+    Frame &frame = stack.back();
+    edges[(u64)frame.caller << 32 | frame.callee].cycles += cycle - frame.start;
+    stack.pop_back();
+}
+
+void
+CPUProfiler::writeFlatProfile(FILE *file, const char *title, size_t limit)
+{
+    std::vector<u16> addrs;
+    u64 total = 0;
+
+    for (u32 i = 0; i < 0x10000; i++) {
+        if (cycles[i]) addrs.push_back((u16)i);
+        total += cycles[i];
+    }
+    std::sort(addrs.begin(), addrs.end(),
+              [this](u16 a, u16 b) { return cycles[a] > cycles[b]; });
+    if (addrs.size() > limit) addrs.resize(limit);
+
+    fprintf(file, "%s: flat profile (%llu cycles)\n\n", title, total);
+    fprintf(file, "    Addr   Instructions         Cycles      Stalls       %%\n");
+
+    for (u16 addr : addrs) {
+        fprintf(file, "    %04X  %13llu  %13llu  %10llu  %6.2f\n",
+                addr, instructions[addr], cycles[addr], stalls[addr],
+                100.0 * cycles[addr] / total);
+    }
+    fprintf(file, "\n");
+}
+
+void
+CPUProfiler::writeCallgraph(FILE *file, const char *title, size_t limit)
+{
+    std::vector<std::pair<u64, Edge>> sorted(edges.begin(), edges.end());
+    std::sort(sorted.begin(), sorted.end(),
+              [](const std::pair<u64, Edge> &a, const std::pair<u64, Edge> &b) {
+        return a.second.cycles > b.second.cycles; });
+    if (sorted.size() > limit) sorted.resize(limit);
+
+    fprintf(file, "%s: callgraph (inclusive cycles of completed calls)\n\n", title);
+    fprintf(file, "    Caller  Callee          Calls         Cycles   Cycles/call\n");
+
+    for (auto &it : sorted) {
+
+        u32 caller = (u32)(it.first >> 32);
+        u16 callee = (u16)it.first;
+        const Edge &edge = it.second;
+
+        if (caller == root) {
+            fprintf(file, "    <root>");
+        } else {
+            fprintf(file, "    %04X  ", caller);
+        }
+        fprintf(file, "  %04X   %12llu   %12llu   %11.1f\n",
+                callee, edge.calls, edge.cycles,
+                edge.calls ? (double)edge.cycles / edge.calls : 0.0);
+    }
+    fprintf(file, "\n");
+}
@@ -0,0 +1,132 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#ifndef _CPU_PROFILER_H
+#define _CPU_PROFILER_H
+
+#include "CPUTypes.h"
+
+#include <stdio.h>
+#include <unordered_map>
+#include <vector>
+
+/* The profiler records how often each instruction has been executed and how
+ * many cycles have been spent on it. Cycles in which the CPU is halted by the
+ * RDY line are charged to the stalled instruction and additionally counted
+ * as stall cycles. The cycles of an interrupt sequence are charged to the
+ * instruction in front of which the interrupt has been taken.
+ *
+ * Besides the flat profile, the profiler builds a callgraph. JSR, BRK, IRQ
+ * and NMI are treated as calls, RTS and RTI as returns. Each call frame
+ * stores the value of the stack pointer after the matching return. Hence,
+ * routines that manipulate the stack (e.g., by discarding a return address
+ * or by jumping via RTS) don't corrupt the call stack. A frame whose return
+ * address has been overwritten by a later call can never be returned from.
+ * It is closed when that call is made and charged with the cycles elapsed
+ * up to this point. Thus, the call stack never grows beyond the size of the
+ * hardware stack.
+ *
+ * The profiler is fed by the debug core of the CPU (see CPU::inDebugCore()).
+ */
+class CPUProfiler {
+
+public:
+
+    // Root of the callgraph (code that has been entered without a call)
+    static const u32 root = 0x10000;
+
+    // Flat profile, indexed by instruction address
+    u64 instructions[0x10000];
+    u64 cycles[0x10000];
+    u64 stalls[0x10000];
+
+    // Edge of the callgraph
+    struct Edge {
+
+        // Number of calls
+        u64 calls;
+
+        // Cycles spent in the callee, including all nested calls
+        u64 cycles;
+    };
+
+    // Callgraph, indexed by caller << 32 | callee
+    std::unordered_map<u64, Edge> edges;
+
+private:
+
+    struct Frame {
+
+        u32 caller;
+        u16 callee;
+        u8 sp;
+        u64 start;
+    };
+
+    // Call stack
+    std::vector<Frame> stack;
+
+    // State of the previous cycle (used to detect stall cycles)
+    long prevNext = -1;
+    bool prevRdy = true;
+
+public:
+
+    CPUProfiler() { clear(); }
+
+    // Deletes all recorded data
+    void clear();
+
+
+    //
+    // Recording (called by the CPU)
+    //
+
+    // Called at the beginning of each cycle
+    void countCycle(u16 pc, long next, bool rdy) {
+
+        cycles[pc]++;
+        if (!prevRdy && next == prevNext) stalls[pc]++;
+        prevNext = next;
+        prevRdy = rdy;
+    }
+
+    // Called when an instruction has been completed
+    void countInstruction(u16 pc) { instructions[pc]++; }
+
+    /* Called when a subroutine or an interrupt handler has been entered. sp is
+     * the value of the stack pointer after the matching return instruction.
+     */
+    void call(u16 target, u8 sp, u64 cycle);
+
+    // Called when an RTS or RTI instruction has been completed
+    void ret(u8 sp, u64 cycle);
+
+private:
+
+    // Closes the innermost frame and charges the elapsed cycles to its edge
+    void close(u64 cycle);
+
+public:
+
+
+    //
+    // Exporting
+    //
+
+    /* Writes the flat profile, sorted by the number of elapsed cycles. At most
+     * 'limit' entries are written.
+     */
+    void writeFlatProfile(FILE *file, const char *title, size_t limit = 100);
+
+    // Writes the callgraph, sorted by the number of elapsed cycles
+    void writeCallgraph(FILE *file, const char *title, size_t limit = 100);
+};
+
+#endif
@@ -0,0 +1,208 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "C64.h"
+
+//
+// TraceCodec
+//
+
+TraceCodec::TraceCodec(const u8 *lengths)
+{
+    memcpy(length, lengths, sizeof(length));
+    reset();
+}
+
+void
+TraceCodec::reset()
+{
+    memset(code, 0, sizeof(code));
+    memset(&prev, 0, sizeof(prev));
+}
+
+//
+// TraceWriter
+//
+
+bool
+TraceWriter::open(const char *path)
+{
+    close();
+
+    if (!(file = fopen(path, "wb"))) return false;
+
+    reset();
+    records = 0;
+    failed = false;
+    memcpy(buffer, traceMagic, sizeof(traceMagic));
+    used = sizeof(traceMagic);
+
+    return true;
+}
+
+void
+TraceWriter::close()
+{
+    if (!file) return;
+
+    flush();
+    if (fclose(file) != 0) failed = true;
+    file = nullptr;
+}
+
+void
+TraceWriter::flush()
+{
+    if (fwrite(buffer, 1, used, file) != used) failed = true;
+    used = 0;
+}
+
+void
+TraceWriter::write(const RecordedInstruction &instr)
+{
+    assert(file);
+
+    // Make sure the largest possible record fits into the buffer
+    if (used + 32 > sizeof(buffer)) flush();
+
+    u8 *tag = buffer + used++;
+    *tag = 0;
+
+    // Elapsed cycles
+    u64 delta = instr.cycle - prev.cycle;
+    do {
+        u8 byte = delta & 0x7F;
+        delta >>= 7;
+        buffer[used++] = delta ? byte | 0x80 : byte;
+    } while (delta);
+
+    // Registers
+    if (instr.a != prev.a) { *tag |= TRACE_A; buffer[used++] = instr.a; }
+    if (instr.x != prev.x) { *tag |= TRACE_X; buffer[used++] = instr.x; }
+    if (instr.y != prev.y) { *tag |= TRACE_Y; buffer[used++] = instr.y; }
+    if (instr.sp != prev.sp) { *tag |= TRACE_SP; buffer[used++] = instr.sp; }
+    if (instr.flags != prev.flags) { *tag |= TRACE_P; buffer[used++] = instr.flags; }
+
+    // Program counter
+    if (instr.pc != nextPC() || records == 0) {
+        *tag |= TRACE_PC;
+        buffer[used++] = LO_BYTE(instr.pc);
+        buffer[used++] = HI_BYTE(instr.pc);
+    }
+
+    // Instruction bytes
+    u8 bytes[3] = { instr.byte1, instr.byte2, instr.byte3 };
+    unsigned len = length[instr.byte1];
+    for (unsigned i = 0; i < len; i++) {
+        if (code[(u16)(instr.pc + i)] != bytes[i]) { *tag |= TRACE_BYTES; break; }
+    }
+    if (*tag & TRACE_BYTES) {
+        for (unsigned i = 0; i < len; i++) {
+            code[(u16)(instr.pc + i)] = bytes[i];
+            buffer[used++] = bytes[i];
+        }
+    }
+
+    prev = instr;
+    records++;
+}
+
+//
+// TraceReader
+//
+
+bool
+TraceReader::open(const char *path)
+{
+    close();
+
+    if (!(file = fopen(path, "rb"))) return false;
+
+    char magic[sizeof(traceMagic)];
+    if (fread(magic, 1, sizeof(magic), file) != sizeof(magic) ||
+        memcmp(magic, traceMagic, sizeof(magic)) != 0) {
+        close();
+        return false;
+    }
+
+    reset();
+    return true;
+}
+
+void
+TraceReader::close()
+{
+    if (!file) return;
+
+    fclose(file);
+    file = nullptr;
+}
+
+bool
+TraceReader::readVarInt(u64 &value)
+{
+    value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+
+        int byte = getc(file);
+        if (byte == EOF) return false;
+
+        value |= (u64)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+bool
+TraceReader::read(RecordedInstruction &instr)
+{
+    assert(file);
+
+    int tag = getc(file);
+    if (tag == EOF) return false;
+
+    u64 delta;
+    if (!readVarInt(delta)) return false;
+
+    instr = prev;
+    instr.cycle += delta;
+
+    // Registers
+    if (tag & TRACE_A) instr.a = (u8)getc(file);
+    if (tag & TRACE_X) instr.x = (u8)getc(file);
+    if (tag & TRACE_Y) instr.y = (u8)getc(file);
+    if (tag & TRACE_SP) instr.sp = (u8)getc(file);
+    if (tag & TRACE_P) instr.flags = (u8)getc(file);
+
+    // Program counter
+    if (tag & TRACE_PC) {
+        u8 lo = (u8)getc(file);
+        u8 hi = (u8)getc(file);
+        instr.pc = LO_HI(lo, hi);
+    } else {
+        instr.pc = nextPC();
+    }
+
+    // Instruction bytes
+    if (tag & TRACE_BYTES) {
+        code[instr.pc] = (u8)getc(file);
+        for (unsigned i = 1; i < length[code[instr.pc]]; i++) {
+            code[(u16)(instr.pc + i)] = (u8)getc(file);
+        }
+    }
+    if (feof(file)) return false;
+
+    unsigned len = length[code[instr.pc]];
+    instr.byte1 = code[instr.pc];
+    instr.byte2 = len > 1 ? code[(u16)(instr.pc + 1)] : 0;
+    instr.byte3 = len > 2 ? code[(u16)(instr.pc + 2)] : 0;
+
+    prev = instr;
+    return true;
+}
@@ -0,0 +1,137 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#ifndef _CPU_TRACE_H
+#define _CPU_TRACE_H
+
+#include "CPUTypes.h"
+
+#include <stdio.h>
+
+/* An instruction trace is a file holding a RecordedInstruction for each
+ * executed instruction. Unlike the log buffer of the CPU debugger, the trace
+ * is unbounded. To keep it small, each record is stored relative to its
+ * predecessor. A record starts with a tag byte, followed by the elapsed
+ * cycles (LEB128 encoded) and all items flagged in the tag:
+ *
+ *    TRACE_A ... TRACE_P : The register has changed (1 byte each)
+ *    TRACE_PC            : The instruction doesn't follow its predecessor
+ *                          in memory (2 bytes, little endian)
+ *    TRACE_BYTES         : The instruction bytes differ from the bytes that
+ *                          have been stored for the same address before
+ *                          (opcode plus operands)
+ *
+ * Because the instruction bytes are only stored on the first execution (or
+ * after the code has been modified), a typical record occupies two or three
+ * bytes.
+ */
+
+static const char traceMagic[8] = { 'V', 'C', '6', '4', 'T', 'R', 'C', 1 };
+
+typedef enum : u8
+{
+    TRACE_A     = 0x01,
+    TRACE_X     = 0x02,
+    TRACE_Y     = 0x04,
+    TRACE_SP    = 0x08,
+    TRACE_P     = 0x10,
+    TRACE_PC    = 0x20,
+    TRACE_BYTES = 0x40
+}
+TraceTag;
+
+// Base class of the trace writer and the trace reader
+class TraceCodec {
+
+protected:
+
+    // The connected file
+    FILE *file = nullptr;
+
+    // Instruction lengths, indexed by opcode
+    u8 length[256];
+
+    // Instruction bytes seen so far, indexed by address
+    u8 code[0x10000];
+
+    // The previous record
+    RecordedInstruction prev;
+
+public:
+
+    TraceCodec(const u8 *lengths);
+
+    bool isOpen() { return file != nullptr; }
+
+protected:
+
+    // Resets the reference state for the first record
+    void reset();
+
+    // Returns the address of the instruction following the previous one
+    u16 nextPC() { return (u16)(prev.pc + length[prev.byte1]); }
+};
+
+class TraceWriter : public TraceCodec {
+
+    // Output buffer
+    u8 buffer[0x10000];
+    size_t used = 0;
+
+    // Number of written records
+    u64 records = 0;
+
+    // Indicates if a write error has occurred
+    bool failed = false;
+
+public:
+
+    TraceWriter(const u8 *lengths) : TraceCodec(lengths) { }
+    ~TraceWriter() { close(); }
+
+    // Creates a new trace file
+    bool open(const char *path);
+
+    // Flushes the output buffer and closes the file
+    void close();
+
+    // Returns the number of written records
+    u64 count() { return records; }
+
+    // Returns true if a write error has occurred (the trace is incomplete)
+    bool hasFailed() { return failed; }
+
+    // Appends a record
+    void write(const RecordedInstruction &instr);
+
+private:
+
+    void flush();
+};
+
+class TraceReader : public TraceCodec {
+
+public:
+
+    TraceReader(const u8 *lengths) : TraceCodec(lengths) { }
+    ~TraceReader() { close(); }
+
+    // Opens an existing trace file
+    bool open(const char *path);
+    void close();
+
+    // Reads the next record. Returns false at the end of the trace
+    bool read(RecordedInstruction &instr);
+
+private:
+
+    bool readVarInt(u64 &value);
+};
+
+#endif
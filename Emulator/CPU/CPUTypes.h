@@ -83,6 +83,19 @@ typedef enum
 }
 Breakpoint;
 
+typedef enum : long
+{
+    WATCH_READ  = 0x01,
+    WATCH_WRITE = 0x02,
+    WATCH_ANY   = 0x03
+}
+WatchAccess;
+
+inline bool isWatchAccess(long value)
+{
+    return value >= WATCH_READ && value <= WATCH_ANY;
+}
+
 //
 // Structures
 //
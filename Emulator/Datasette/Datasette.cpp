@@ -25,6 +25,26 @@ Datasette::_reset()
     RESET_SNAPSHOT_ITEMS
     
     rewind();
+    
+    edgeBase = 0;
+    scheduleNextEdge();
+}
+
+size_t
+Datasette::didLoadFromBuffer(u8 *buffer)
+{
+    edgeBase = cpu.cycle;
+    scheduleNextEdge();
+    
+    return 0;
+}
+
+size_t
+Datasette::willSaveToBuffer(u8 *buffer)
+{
+    updateEdgeCounters(cpu.cycle);
+    
+    return 0;
 }
 
 void
@@ -151,6 +171,9 @@ Datasette::pressPlay()
     nextRisingEdge = length / 2;
     nextFallingEdge = length;
     advanceHead();
+    
+    edgeBase = cpu.cycle;
+    scheduleNextEdge();
 }
 
 void
@@ -159,20 +182,56 @@ Datasette::pressStop()
     debug(TAP_DEBUG, "pressStop\n");
     motor = false;
     playKey = false;
+    
+    scheduleNextEdge();
+}
+
+void
+Datasette::setMotor(bool value)
+{
+    if (motor == value) return;
+    
+    // The motor is switched by the CPU. The current cycle is not emulated yet
+    updateEdgeCounters(cpu.cycle - 1);
+    motor = value;
+    scheduleNextEdge();
 }
 
 void
-Datasette::_execute()
+Datasette::updateEdgeCounters(Cycle cycle)
 {
-    // Only proceed if the datasette is active
-    if (!hasTape() || !playKey || !motor) return;
+    if (isMoving()) {
         
-    if (--nextRisingEdge == 0) {
+        nextRisingEdge -= cycle - edgeBase;
+        nextFallingEdge -= cycle - edgeBase;
+    }
+    edgeBase = cycle;
+}
+
+void
+Datasette::scheduleNextEdge()
+{
+    Cycle trigger = NEVER;
+    
+    if (isMoving()) {
+        
+        if (nextRisingEdge > 0) trigger = edgeBase + nextRisingEdge;
+        if (nextFallingEdge > 0) trigger = MIN(trigger, edgeBase + nextFallingEdge);
+    }
+    scheduler.schedule(EVENT_DATASETTE, trigger);
+}
+
+void
+Datasette::execute(Cycle cycle)
+{
+    updateEdgeCounters(cycle);
+    
+    if (nextRisingEdge == 0) {
         
         cia1.triggerRisingEdgeOnFlagPin();
     }
 
-    if (--nextFallingEdge == 0) {
+    if (nextFallingEdge == 0) {
         
         cia1.triggerFallingEdgeOnFlagPin();
 
@@ -190,4 +249,6 @@ Datasette::_execute()
             pressStop();
         }
     }
+    
+    scheduleNextEdge();
 }
@@ -67,6 +67,12 @@ class Datasette : public C64Component {
     // Indicates whether the motor is switched on
     bool motor = false;
     
+    /* The cycle up to which nextRisingEdge and nextFallingEdge have been
+     * counted down. While the tape is moving, the counters are only updated
+     * when an edge is due or the motor state changes.
+     */
+    Cycle edgeBase = 0;
+    
     
     //
     // Initializing
@@ -115,6 +121,8 @@ private:
     size_t _size() override { COMPUTE_SNAPSHOT_SIZE }
     size_t _load(u8 *buffer) override { LOAD_SNAPSHOT_ITEMS }
     size_t _save(u8 *buffer) override { SAVE_SNAPSHOT_ITEMS }
+    size_t didLoadFromBuffer(u8 *buffer) override;
+    size_t willSaveToBuffer(u8 *buffer) override;
     
 
     //
@@ -189,15 +197,21 @@ public:
     bool getMotor() { return motor; }
 
     // Switches the motor on or off
-    void setMotor(bool value) { motor = value; }
+    void setMotor(bool value);
 
-    // Emulates the datasette
-    void execute() { if (playKey && motor) _execute(); }
+    // Returns true if the tape is moving
+    bool isMoving() { return hasTape() && playKey && motor; }
+
+    // Emulates the datasette (called by the scheduler when an edge is due)
+    void execute(Cycle cycle);
 
 private:
 
-    // Internal execution function
-    void _execute();
+    // Counts down the edge counters up to the specified cycle
+    void updateEdgeCounters(Cycle cycle);
+
+    // Informs the scheduler about the next edge on the data line
+    void scheduleNextEdge();
 };
 
 #endif
@@ -193,6 +193,14 @@ Disk::_reset()
     RESET_SNAPSHOT_ITEMS
 }
 
+size_t
+Disk::didLoadFromBuffer(u8 *buffer)
+{
+    // The halftrack data may have been replaced as a whole
+    setDirty(true);
+    return 0;
+}
+
 void
 Disk::_dump()
 {
@@ -304,6 +312,7 @@ Disk::clearHalftrack(Halftrack ht)
 {
     memset(&data.halftrack[ht], 0x55, sizeof(data.halftrack[ht]));
     length.halftrack[ht] = sizeof(data.halftrack[ht]) * 8;
+    dirty[ht] = true;
 }
 
 void
@@ -117,6 +117,20 @@ public:
     DiskLength length;
 
     
+    //
+    // Change tracking
+    //
+    
+    /* Indicates which halftracks have been modified since the flags have been
+     * cleared the last time. The information is used to store the modified
+     * halftracks in delta snapshots (see DeltaSnapshot).
+     */
+    bool dirty[highestHalftrack + 1] = { };
+    
+    // Indicates if the halftrack data is part of the serialized state
+    bool serializeData = true;
+    
+    
     //
     // Debug information
     //
@@ -202,8 +216,12 @@ private:
         worker
         
         & writeProtected
-        & modified
-        & data
+        & modified;
+        
+        if (serializeData) worker & data;
+        
+        worker
+        
         & length;
     }
     
@@ -215,6 +233,7 @@ private:
     size_t _size() override { COMPUTE_SNAPSHOT_SIZE }
     size_t _load(u8 *buffer) override { LOAD_SNAPSHOT_ITEMS }
     size_t _save(u8 *buffer) override { SAVE_SNAPSHOT_ITEMS }
+    size_t didLoadFromBuffer(u8 *buffer) override;
     
     
     //
@@ -230,6 +249,9 @@ public:
     bool isModified() { return modified; }
     void setModified(bool b);
     
+    // Marks all halftracks as modified or unmodified
+    void setDirty(bool value) { memset(dirty, value, sizeof(dirty)); }
+    
     
     //
     // Handling GCR encoded data
@@ -295,6 +317,7 @@ public:
     }
     void _writeBitToHalftrack(Halftrack ht, HeadPos pos, bool bit) {
         assert(isValidHeadPos(ht, pos));
+        dirty[ht] = true;
         if (bit) {
             data.halftrack[ht][pos / 8] |= (0x0080 >> (pos % 8));
         } else {
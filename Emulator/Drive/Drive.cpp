@@ -41,6 +41,8 @@ Drive::_reset()
 
     cpu.reg.pc = 0xEAA0;
     halftrack = 41;
+    
+    scheduleExecution();
 }
 
 long
@@ -155,6 +157,23 @@ Drive::_dump()
     startTracing();
 }
 
+size_t
+Drive::didLoadFromBuffer(u8 *buffer)
+{
+    // The activity flag is not stored in snapshots. Derive it from the config
+    active = config.connected && config.switchedOn;
+    scheduleExecution();
+    
+    return 0;
+}
+
+void
+Drive::scheduleExecution()
+{
+    EventSlot slot = deviceNr == DRIVE8 ? EVENT_DRIVE8 : EVENT_DRIVE9;
+    scheduler.schedule(slot, active && !iec.hasLazyDrives() ? 0 : NEVER);
+}
+
 void
 Drive::_run()
 {
@@ -172,7 +191,11 @@ Drive::execute(u64 duration)
             
             // Execute CPU and VIAs
             u64 cycle = ++cpu.cycle;
-            cpu.executeOneCycle();
+            if (unlikely(cpu.inDebugCore())) {
+                cpu.executeOneCycle<true>();
+            } else {
+                cpu.executeOneCycle<false>();
+            }
             if (cycle >= via1.wakeUpCycle) via1.execute(); else via1.idleCounter++;
             if (cycle >= via2.wakeUpCycle) via2.execute(); else via2.idleCounter++;
             updateByteReady();
@@ -271,6 +271,7 @@ private:
     size_t _size() override { COMPUTE_SNAPSHOT_SIZE }
     size_t _load(u8 *buffer) override { LOAD_SNAPSHOT_ITEMS }
     size_t _save(u8 *buffer) override { SAVE_SNAPSHOT_ITEMS }
+    size_t didLoadFromBuffer(u8 *buffer) override;
     
 private:
     
@@ -286,6 +287,12 @@ public:
     // Checks whether the drive is active (connected and switched on)
     bool isActive() { return active; }
     
+    /* Informs the scheduler whether the drive needs to be executed in every
+     * cycle. This is the case for active drives, unless the drives are
+     * emulated lazily (see IEC::catchUpDrives()).
+     */
+    void scheduleExecution();
+    
     // Returns the device number
     DriveID getDeviceNr() { return deviceNr; }
         
@@ -61,4 +61,10 @@ typedef struct
 }
 DriveConfig;
 
+typedef struct
+{
+    bool lazyDrives;
+}
+IECConfig;
+
 #endif
@@ -12,6 +12,8 @@
 IEC::IEC(C64 &ref) : C64Component(ref)
 {
   	setDescription("IEC");
+    
+    config.lazyDrives = false;
 }
 
 void 
@@ -34,6 +36,60 @@ IEC::_reset()
     ciaAtn = 1;
     ciaClock = 1;
     ciaData = 1;
+    
+    scheduler.cancel(EVENT_IEC);
+    driveCycle = cpu.cycle;
+}
+
+long
+IEC::getConfigItem(ConfigOption option)
+{
+    switch (option) {
+            
+        case OPT_LAZY_DRIVES:  return config.lazyDrives;
+            
+        default:
+            assert(false);
+            return 0;
+    }
+}
+
+bool
+IEC::setConfigItem(ConfigOption option, long value)
+{
+    switch (option) {
+            
+        case OPT_LAZY_DRIVES:
+            
+            if (config.lazyDrives == value) {
+                return false;
+            }
+            
+            suspend();
+            catchUpDrives(cpu.cycle);
+            config.lazyDrives = value;
+            driveCycle = cpu.cycle;
+            drive8.scheduleExecution();
+            drive9.scheduleExecution();
+            resume();
+            return true;
+            
+        default:
+            return false;
+    }
+}
+
+size_t
+IEC::didLoadFromBuffer(u8 *buffer)
+{
+    driveCycle = cpu.cycle;
+    
+    if (isDirtyC64Side) {
+        scheduler.schedule(EVENT_IEC, 0);
+    } else {
+        scheduler.cancel(EVENT_IEC);
+    }
+    return 0;
 }
 
 void 
@@ -140,6 +196,9 @@ IEC::updateIecLines()
 void
 IEC::updateIecLinesC64Side()
 {
+    // Let the drives see the old values up to the previous cycle
+    catchUpDrives(cpu.cycle - 1);
+    
     // Get bus signals from C64 side
     u8 ciaBits = cia2.getPA();
     ciaAtn = !!(ciaBits & 0x08);
@@ -148,6 +207,7 @@ IEC::updateIecLinesC64Side()
     
     updateIecLines();
     isDirtyC64Side = false;
+    scheduler.cancel(EVENT_IEC);
 }
 
 void
@@ -182,3 +242,31 @@ IEC::execute()
 	}
 }
 
+void
+IEC::catchUpDrives(Cycle cycle)
+{
+    if (!config.lazyDrives || cycle <= driveCycle) return;
+    
+    bool active8 = drive8.isActive();
+    bool active9 = drive9.isActive();
+    u64 duration = c64.durationOfOneCycle;
+    
+    if (active8 && active9) {
+        
+        // Both drives are connected to the bus. Keep them in lockstep
+        for (Cycle i = driveCycle; i < cycle; i++) {
+            drive8.execute(duration);
+            drive9.execute(duration);
+        }
+        
+    } else if (active8) {
+        
+        drive8.execute((cycle - driveCycle) * duration);
+        
+    } else if (active9) {
+        
+        drive9.execute((cycle - driveCycle) * duration);
+    }
+    
+    driveCycle = cycle;
+}
@@ -14,6 +14,9 @@
 
 class IEC : public C64Component {
 
+    // Current configuration
+    IECConfig config;
+    
 public:
     
 	// Current values of the IEC bus lines
@@ -53,6 +56,9 @@ private:
 	// Used to determine if the bus is idle or if data is transferred
 	u32 busActivity;
 	
+    // The latest C64 cycle the drives have been emulated for (lazy mode)
+    Cycle driveCycle = 0;
+    
     
     //
     // Initializing
@@ -67,6 +73,21 @@ private:
     void _reset() override;
 
     
+    //
+    // Configuring
+    //
+    
+public:
+    
+    IECConfig getConfig() { return config; }
+    
+    long getConfigItem(ConfigOption option);
+    bool setConfigItem(ConfigOption option, long value) override;
+    
+    // Returns true if the drives are emulated lazily
+    bool hasLazyDrives() { return config.lazyDrives; }
+    
+    
     //
     // Analyzing
     //
@@ -113,6 +134,7 @@ private:
     size_t _size() override { COMPUTE_SNAPSHOT_SIZE }
     size_t _load(u8 *buffer) override { LOAD_SNAPSHOT_ITEMS }
     size_t _save(u8 *buffer) override { SAVE_SNAPSHOT_ITEMS }
+    size_t didLoadFromBuffer(u8 *buffer) override;
     
     
     //
@@ -126,7 +148,8 @@ public:
     
     // Requensts an update of the bus lines from the C64 side
     // DEPRECATED
-    void setNeedsUpdateC64Side() { isDirtyC64Side = true; }
+    void setNeedsUpdateC64Side() {
+        isDirtyC64Side = true; scheduler.schedule(EVENT_IEC, 0); }
 
     // Requensts an update of the bus lines from the drive side
     // DEPRECATED
@@ -144,6 +167,17 @@ public:
      */
 	void execute();
     
+    /* Emulates the drives up to the specified C64 cycle. In lazy mode, the
+     * drives are not executed in every cycle. Instead, they catch up with
+     * the C64 in a single batch right before the C64 interacts with the bus
+     * (i.e., when the bus lines are updated from the C64 side or port A of
+     * CIA2 is read) and at the end of each frame. Because the drives only
+     * communicate with the C64 over the bus, the result is the same as in
+     * cycle-by-cycle mode. In cycle-by-cycle mode, this function does
+     * nothing.
+     */
+    void catchUpDrives(Cycle cycle);
+    
 private:
     
     void updateIecLines();
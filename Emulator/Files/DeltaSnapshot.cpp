@@ -0,0 +1,181 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "C64.h"
+
+size_t
+DeltaSnapshot::footprint()
+{
+    return sizeof(DeltaSnapshot) +
+    pages.capacity() * sizeof(u32) +
+    pageData.capacity() +
+    halftracks.capacity() * sizeof(u16) +
+    halftrackData.capacity();
+}
+
+DeltaEncoder::~DeltaEncoder()
+{
+    delete [] state;
+    delete [] buffer;
+}
+
+void
+DeltaEncoder::reset()
+{
+    stateSize = 0;
+}
+
+Disk &
+DeltaEncoder::disk(C64 &c64, unsigned nr)
+{
+    assert(nr < 2);
+    return nr == 0 ? c64.drive8.disk : c64.drive9.disk;
+}
+
+size_t
+DeltaEncoder::serialize(C64 &c64)
+{
+    for (unsigned i = 0; i < 2; i++) disk(c64, i).serializeData = false;
+
+    size_t size = c64.size();
+
+    // Make sure both buffers are large enough
+    if (size > capacity) {
+
+        u8 *newState = new u8[size];
+        memcpy(newState, state, stateSize);
+        delete [] state;
+        delete [] buffer;
+        state = newState;
+        buffer = new u8[size];
+        capacity = size;
+    }
+
+    c64.save(buffer);
+
+    for (unsigned i = 0; i < 2; i++) disk(c64, i).serializeData = true;
+    return size;
+}
+
+DeltaSnapshot *
+DeltaEncoder::encode(C64 &c64, bool keyframe)
+{
+    DeltaSnapshot *snapshot = new DeltaSnapshot();
+    size_t size = serialize(c64);
+
+    // Store the complete state if there is no matching base state
+    if (size != stateSize) keyframe = true;
+
+    snapshot->frame = c64.frame;
+    snapshot->keyframe = keyframe;
+    snapshot->stateSize = size;
+
+    // Collect all modified pages
+    size_t numPages = (size + DeltaSnapshot::pageSize - 1) / DeltaSnapshot::pageSize;
+    for (size_t i = 0; i < numPages; i++) {
+
+        size_t offset = i * DeltaSnapshot::pageSize;
+        size_t count = MIN(DeltaSnapshot::pageSize, size - offset);
+
+        if (keyframe || memcmp(buffer + offset, state + offset, count) != 0) {
+            snapshot->pages.push_back((u32)i);
+            snapshot->pageData.insert(snapshot->pageData.end(),
+                                      buffer + offset, buffer + offset + count);
+        }
+    }
+
+    // Collect all modified halftracks
+    for (unsigned i = 0; i < 2; i++) {
+
+        Disk &d = disk(c64, i);
+        for (Halftrack ht = 1; ht <= highestHalftrack; ht++) {
+
+            if (keyframe && d.halftrackIsEmpty(ht)) {
+                snapshot->halftracks.push_back((u16)(i << 8 | ht) |
+                                               DeltaSnapshot::emptyHalftrack);
+                continue;
+            }
+            if (keyframe || d.dirty[ht]) {
+                snapshot->halftracks.push_back((u16)(i << 8 | ht));
+                snapshot->halftrackData.insert(snapshot->halftrackData.end(),
+                                               d.data.halftrack[ht],
+                                               d.data.halftrack[ht] + maxBytesOnTrack);
+            }
+        }
+        d.setDirty(false);
+    }
+
+    // The new state is the base for the next snapshot
+    std::swap(state, buffer);
+    stateSize = size;
+
+    snapshot->pages.shrink_to_fit();
+    snapshot->pageData.shrink_to_fit();
+    snapshot->halftracks.shrink_to_fit();
+    snapshot->halftrackData.shrink_to_fit();
+    return snapshot;
+}
+
+void
+DeltaEncoder::decode(C64 &c64, DeltaSnapshot **chain, size_t count)
+{
+    assert(count > 0);
+    assert(chain[0]->keyframe);
+
+    size_t size = chain[count - 1]->stateSize;
+
+    if (size > capacity) {
+
+        delete [] state;
+        delete [] buffer;
+        state = new u8[size];
+        buffer = new u8[size];
+        capacity = size;
+    }
+
+    // Rebuild the serialized state and the disk data
+    for (size_t i = 0; i < count; i++) {
+
+        DeltaSnapshot *snapshot = chain[i];
+        assert(i == 0 || snapshot->stateSize == size);
+
+        const u8 *src = snapshot->pageData.data();
+        for (auto page : snapshot->pages) {
+
+            size_t offset = page * DeltaSnapshot::pageSize;
+            size_t bytes = MIN(DeltaSnapshot::pageSize, size - offset);
+            memcpy(state + offset, src, bytes);
+            src += bytes;
+        }
+
+        src = snapshot->halftrackData.data();
+        for (auto ht : snapshot->halftracks) {
+
+            Disk &d = disk(c64, (ht >> 8) & 1);
+            u8 *dst = d.data.halftrack[ht & 0xFF];
+
+            if (ht & DeltaSnapshot::emptyHalftrack) {
+                memset(dst, 0x55, maxBytesOnTrack);
+            } else {
+                memcpy(dst, src, maxBytesOnTrack);
+                src += maxBytesOnTrack;
+            }
+        }
+    }
+
+    // Restore the emulator state
+    for (unsigned i = 0; i < 2; i++) disk(c64, i).serializeData = false;
+    c64.loadFromBuffer(state);
+    for (unsigned i = 0; i < 2; i++) {
+        disk(c64, i).serializeData = true;
+        disk(c64, i).setDirty(false);
+    }
+
+    stateSize = size;
+}
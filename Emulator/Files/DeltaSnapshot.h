@@ -0,0 +1,140 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#ifndef _DELTA_SNAPSHOT_H
+#define _DELTA_SNAPSHOT_H
+
+#include "C64Types.h"
+
+#include <vector>
+
+class C64;
+class Disk;
+
+/* A delta snapshot only stores the parts of the emulator state that have
+ * changed since the previous snapshot in a chain. Delta snapshots are taken
+ * by a DeltaEncoder. The first snapshot of each chain is a keyframe which
+ * contains the complete state. A state can be restored by applying the
+ * keyframe and all subsequent snapshots up to the desired one.
+ *
+ * The state is split into two parts:
+ *
+ *   - The serialized emulator state without the disk data. It is divided into
+ *     pages and only the pages that differ from the previous state are
+ *     stored. Because the serialized state is compared with the previous one,
+ *     no modification can slip through, no matter which component has
+ *     written the data.
+ *
+ *   - The disk data. Disks keep track of the modified halftracks themselves,
+ *     because comparing the data of two disks would be way too expensive.
+ *     Only the modified halftracks are stored.
+ */
+class DeltaSnapshot {
+
+    friend class DeltaEncoder;
+
+public:
+
+    // Granularity of the serialized state
+    static const size_t pageSize = 256;
+
+    // Marks a stored halftrack as empty (no halftrack data is stored)
+    static const u16 emptyHalftrack = 0x8000;
+
+private:
+
+    // Frame in which this snapshot has been taken
+    u64 frame = 0;
+
+    // Indicates if this snapshot contains the complete state
+    bool keyframe = false;
+
+    // Size of the serialized state
+    size_t stateSize = 0;
+
+    // Numbers and contents of all stored pages
+    std::vector<u32> pages;
+    std::vector<u8> pageData;
+
+    /* Drive numbers and halftrack numbers of all stored halftracks. Keyframes
+     * store empty halftracks without data to save memory.
+     */
+    std::vector<u16> halftracks;
+
+    // Contents of all stored halftracks
+    std::vector<u8> halftrackData;
+
+
+    //
+    // Accessing properties
+    //
+
+public:
+
+    u64 getFrame() { return frame; }
+    bool isKeyframe() { return keyframe; }
+
+    // Returns the number of bytes occupied by this snapshot
+    size_t footprint();
+};
+
+/* A delta encoder takes and restores delta snapshots. It keeps a copy of the
+ * serialized state of the most recent snapshot, which serves as the base for
+ * the next one.
+ */
+class DeltaEncoder {
+
+    // Serialized state of the most recently taken or restored snapshot
+    u8 *state = nullptr;
+    size_t stateSize = 0;
+
+    // Work buffer
+    u8 *buffer = nullptr;
+    size_t capacity = 0;
+
+
+    //
+    // Initializing
+    //
+
+public:
+
+    ~DeltaEncoder();
+
+    // Forgets the previous state (the next snapshot will be a keyframe)
+    void reset();
+
+
+    //
+    // Taking and restoring snapshots
+    //
+
+public:
+
+    /* Takes a delta snapshot. If 'keyframe' is true or if the size of the
+     * serialized state has changed, the complete state is stored.
+     */
+    DeltaSnapshot *encode(C64 &c64, bool keyframe = false);
+
+    /* Restores the state of the last snapshot in the provided chain. The first
+     * snapshot must be a keyframe. Afterwards, the restored snapshot serves as
+     * the base for the next snapshot.
+     */
+    void decode(C64 &c64, DeltaSnapshot **chain, size_t count);
+
+private:
+
+    // Serializes the emulator state (without the disk data) into 'buffer'
+    size_t serialize(C64 &c64);
+
+    // Returns the disk of a drive (0 = drive 8, 1 = drive 9)
+    Disk &disk(C64 &c64, unsigned nr);
+};
+
+#endif
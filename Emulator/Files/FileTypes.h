@@ -116,4 +116,22 @@ inline bool isRomRevision(long value)
     return value >= 0 && value <= ROM_CNT;
 }
 
+
+//
+// Structures
+//
+
+typedef struct
+{
+    // Maximum memory occupied by the rewind buffer in MB (0 = disabled)
+    long budget;
+
+    // Number of frames between two snapshots
+    long interval;
+
+    // Number of snapshots between two keyframes
+    long keyframes;
+}
+RewindConfig;
+
 #endif
@@ -0,0 +1,175 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "C64.h"
+#include <algorithm>
+
+RewindBuffer::RewindBuffer(C64 &ref) : C64Component(ref)
+{
+    setDescription("RewindBuffer");
+
+    config.budget = 0;
+    config.interval = 1;
+    config.keyframes = 100;
+}
+
+RewindBuffer::~RewindBuffer()
+{
+    clear();
+}
+
+long
+RewindBuffer::getConfigItem(ConfigOption option)
+{
+    switch (option) {
+
+        case OPT_REWIND_BUFFER:     return config.budget;
+        case OPT_REWIND_INTERVAL:   return config.interval;
+        case OPT_REWIND_KEYFRAMES:  return config.keyframes;
+
+        default:
+            assert(false);
+            return 0;
+    }
+}
+
+bool
+RewindBuffer::setConfigItem(ConfigOption option, long value)
+{
+    switch (option) {
+
+        case OPT_REWIND_BUFFER:
+
+            if (value < 0 || value > 4096) {
+                warn("Invalid rewind buffer size: %d MB\n", value);
+                return false;
+            }
+            if (config.budget == value) {
+                return false;
+            }
+
+            suspend();
+            config.budget = value;
+            if (isEnabled()) trim(); else clear();
+            resume();
+            return true;
+
+        case OPT_REWIND_INTERVAL:
+
+            if (value < 1 || value > 0xFFFF) {
+                warn("Invalid rewind interval: %d\n", value);
+                return false;
+            }
+
+            config.interval = value;
+            return true;
+
+        case OPT_REWIND_KEYFRAMES:
+
+            if (value < 1 || value > 0xFFFF) {
+                warn("Invalid keyframe interval: %d\n", value);
+                return false;
+            }
+
+            config.keyframes = value;
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+void
+RewindBuffer::_dump()
+{
+    msg("    Memory budget : %d MB\n", config.budget);
+    msg("         Interval : %d frames\n", config.interval);
+    msg("        Keyframes : Every %d snapshots\n", config.keyframes);
+    msg("        Snapshots : %d\n", count());
+    msg("           Frames : %lld - %lld\n", oldestFrame(), latestFrame());
+    msg("      Memory used : %d KB\n", used / 1024);
+    msg("\n");
+}
+
+void
+RewindBuffer::clear()
+{
+    for (auto snapshot : history) delete snapshot;
+    history.clear();
+
+    used = 0;
+    chainLength = 0;
+    encoder.reset();
+}
+
+void
+RewindBuffer::vsyncHandler()
+{
+    if (!isEnabled() || c64.frame % config.interval != 0) return;
+
+    DeltaSnapshot *snapshot = encoder.encode(c64, chainLength >= config.keyframes);
+
+    chainLength = snapshot->isKeyframe() ? 1 : chainLength + 1;
+    used += snapshot->footprint();
+    history.push_back(snapshot);
+
+    trim();
+}
+
+bool
+RewindBuffer::seek(u64 frame)
+{
+    // Find the latest snapshot taken in or before the requested frame
+    auto it = std::upper_bound(history.begin(), history.end(), frame,
+                               [](u64 f, DeltaSnapshot *s) { return f < s->getFrame(); });
+    if (it == history.begin()) return false;
+    size_t last = it - history.begin() - 1;
+
+    // Find the keyframe of the chain
+    size_t first = last;
+    while (!history[first]->isKeyframe()) first--;
+
+    // Decode the chain
+    std::vector<DeltaSnapshot *> chain(history.begin() + first,
+                                       history.begin() + last + 1);
+    encoder.decode(c64, chain.data(), chain.size());
+
+    // Discard all snapshots from the abandoned timeline
+    while (history.size() > last + 1) {
+        used -= history.back()->footprint();
+        delete history.back();
+        history.pop_back();
+    }
+    chainLength = last - first + 1;
+
+    debug(SNP_DEBUG, "Rewound to frame %lld\n", history.back()->getFrame());
+    return true;
+}
+
+void
+RewindBuffer::trim()
+{
+    size_t budget = (size_t)config.budget << 20;
+
+    while (used > budget) {
+
+        // Find the beginning of the second chain
+        size_t next = 1;
+        while (next < history.size() && !history[next]->isKeyframe()) next++;
+
+        // Never discard the chain that is currently recorded
+        if (next == history.size()) break;
+
+        for (size_t i = 0; i < next; i++) {
+            used -= history.front()->footprint();
+            delete history.front();
+            history.pop_front();
+        }
+    }
+}
@@ -0,0 +1,146 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#ifndef _REWIND_BUFFER_H
+#define _REWIND_BUFFER_H
+
+#include "C64Component.h"
+#include "DeltaSnapshot.h"
+
+#include <deque>
+
+/* The rewind buffer records the emulator state in regular intervals. It is
+ * organized as a ring buffer of delta snapshots, which form chains starting
+ * with a keyframe. If the recorded snapshots exceed the memory budget, the
+ * oldest chain is discarded.
+ *
+ * Snapshots are taken by the emulator thread at the end of a frame. Seeking
+ * back to a recorded frame decodes a single chain and is thus bounded by the
+ * number of snapshots between two keyframes. All snapshots recorded after the
+ * restored one are discarded, i.e., the emulator starts a new timeline.
+ */
+class RewindBuffer : public C64Component {
+
+    // Current configuration
+    RewindConfig config;
+
+    // Takes and restores the delta snapshots
+    DeltaEncoder encoder;
+
+    // Recorded snapshots (oldest first)
+    std::deque<DeltaSnapshot *> history;
+
+    // Number of bytes occupied by all recorded snapshots
+    size_t used = 0;
+
+    // Number of snapshots in the latest chain
+    long chainLength = 0;
+
+public:
+
+    // Requested target frame of a pending seek operation (see RL_REWIND)
+    u64 target = 0;
+
+
+    //
+    // Initializing
+    //
+
+public:
+
+    RewindBuffer(C64 &ref);
+    ~RewindBuffer();
+
+private:
+
+    void _reset() override { clear(); }
+
+
+    //
+    // Configuring
+    //
+
+public:
+
+    RewindConfig getConfig() { return config; }
+
+    long getConfigItem(ConfigOption option);
+    bool setConfigItem(ConfigOption option, long value) override;
+
+    // Returns true if the emulator state is recorded
+    bool isEnabled() { return config.budget > 0; }
+
+
+    //
+    // Analyzing
+    //
+
+private:
+
+    void _dump() override;
+
+
+    //
+    // Serializing
+    //
+
+private:
+
+    size_t _size() override { return 0; }
+    size_t _load(u8 *buffer) override { return 0; }
+    size_t _save(u8 *buffer) override { return 0; }
+
+
+    //
+    // Accessing the recorded history
+    //
+
+public:
+
+    // Returns the number of recorded snapshots
+    size_t count() { return history.size(); }
+
+    // Returns the number of bytes occupied by all recorded snapshots
+    size_t footprint() { return used; }
+
+    // Returns the frames of the oldest and the most recent snapshot
+    u64 oldestFrame() { return history.empty() ? 0 : history.front()->getFrame(); }
+    u64 latestFrame() { return history.empty() ? 0 : history.back()->getFrame(); }
+
+    /* Discards all recorded snapshots. The history is cleared whenever the
+     * emulator state changes by other means than emulation, i.e., on reset
+     * and when an external snapshot is restored. Otherwise, the history
+     * would mix up snapshots from different timelines.
+     */
+    void clear();
+
+
+    //
+    // Recording and restoring
+    //
+
+public:
+
+    // Records a snapshot if due (called by the C64 at the end of each frame)
+    void vsyncHandler();
+
+    /* Restores the latest recorded snapshot that has been taken in or before
+     * the specified frame. Returns false if no such snapshot exists. This
+     * function must be called while the emulator is paused or from within
+     * the emulator thread (see C64::requestRewind()).
+     */
+    bool seek(u64 frame);
+
+private:
+
+    // Discards the oldest chains until the memory budget is met
+    void trim();
+};
+
+#endif
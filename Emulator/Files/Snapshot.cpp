@@ -147,17 +147,8 @@ Snapshot::takeScreenshot(C64 *c64)
 {
     SnapshotHeader *header = (SnapshotHeader *)data;
     
-    unsigned xStart = FIRST_VISIBLE_PIXEL;
-    unsigned yStart = FIRST_VISIBLE_LINE;
     header->screenshot.width = VISIBLE_PIXELS;
     header->screenshot.height = c64->vic.numVisibleRasterlines();
     
-    u32 *source = (u32 *)c64->vic.stableEmuTexture();
-    u32 *target = header->screenshot.screen;
-    source += xStart + yStart * TEX_WIDTH;
-    for (unsigned i = 0; i < header->screenshot.height; i++) {
-        memcpy(target, source, header->screenshot.width * 4);
-        target += header->screenshot.width;
-        source += TEX_WIDTH;
-    }
+    c64->vic.convertFinishedFrame(header->screenshot.screen, PIXEL_RGBA);
 }
@@ -28,7 +28,8 @@ drive9(ref.drive9),
 datasette(ref.datasette),
 mouse(ref.mouse),
 messageQueue(ref.messageQueue),
-oscillator(ref.oscillator)
+oscillator(ref.oscillator),
+scheduler(ref.scheduler)
 {
 };
 
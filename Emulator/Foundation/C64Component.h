@@ -11,6 +11,7 @@
 #define _C64_COMPONENT_H
 
 #include "HardwareComponent.h"
+#include "Scheduler.h"
 
 //
 // Forward declarations of all components
@@ -75,6 +76,7 @@ protected:
     Mouse &mouse;
     MessageQueue &messageQueue;
     Oscillator &oscillator;
+    Scheduler &scheduler;
     
     Drive *drive[2] = { &drive8, &drive9 };
 
@@ -241,6 +241,15 @@ HardwareComponent::setWarp(bool enable)
      _setWarp(enable);
 }
 
+void
+HardwareComponent::propagateWarp()
+{
+    for (HardwareComponent *c : subComponents) {
+        c->setWarp(warpMode);
+    }
+    _setWarp(warpMode);
+}
+
 void
 HardwareComponent::setDebug(bool enable)
 {
@@ -243,6 +243,12 @@ protected:
     void setWarp(bool enable);
     virtual void _setWarp(bool enable) { }
     
+    /* Applies the current warp flag to all subcomponents and to this component.
+     * In contrast to setWarp(), this is done even if the flag hasn't changed,
+     * e.g., because it has just been restored from a snapshot.
+     */
+    void propagateWarp();
+    
     // Switches debug mode on or off
     void setDebug(bool enable);
     virtual void _setDebug(bool enable) { }
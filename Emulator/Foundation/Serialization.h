@@ -17,6 +17,15 @@
 #include "envelope.h"
 
 #include <arpa/inet.h>
+#include <type_traits>
+
+/* Arrays of single byte integers are processed as a whole. Since the byte
+ * order doesn't matter for these types, bulk copies produce the same stream
+ * as serializing the elements one by one. All large arrays (RAM, ROM, disk
+ * data) are of this kind.
+ */
+template <class T> constexpr bool isByteType =
+std::is_integral<T>::value && sizeof(T) == 1 && !std::is_same<T, bool>::value;
 
 //
 // Basic memory buffer I/O
@@ -150,8 +159,12 @@ public:
     template <class T, size_t N>
     SerCounter& operator&(T (&v)[N])
     {
-        for(size_t i = 0; i < N; ++i) {
-            *this & v[i];
+        if constexpr (isByteType<T>) {
+            count += N;
+        } else {
+            for(size_t i = 0; i < N; ++i) {
+                *this & v[i];
+            }
         }
         return *this;
     }
@@ -221,8 +234,12 @@ public:
     template <class T, size_t N>
     SerReader& operator&(T (&v)[N])
     {
-        for(size_t i = 0; i < N; ++i) {
-            *this & v[i];
+        if constexpr (isByteType<T>) {
+            copy(v, N);
+        } else {
+            for(size_t i = 0; i < N; ++i) {
+                *this & v[i];
+            }
         }
         return *this;
     }
@@ -298,8 +315,12 @@ public:
     template <class T, size_t N>
     SerWriter& operator&(T (&v)[N])
     {
-        for(size_t i = 0; i < N; ++i) {
-            *this & v[i];
+        if constexpr (isByteType<T>) {
+            copy(v, N);
+        } else {
+            for(size_t i = 0; i < N; ++i) {
+                *this & v[i];
+            }
         }
         return *this;
     }
@@ -357,8 +378,12 @@ public:
     template <class T, size_t N>
     SerResetter& operator&(T (&v)[N])
     {
-        for(size_t i = 0; i < N; ++i) {
-            *this & v[i];
+        if constexpr (isByteType<T>) {
+            memset(v, 0, N);
+        } else {
+            for(size_t i = 0; i < N; ++i) {
+                *this & v[i];
+            }
         }
         return *this;
     }
@@ -160,6 +160,24 @@ bool matchingFileHeader(const char *path, const u8 *header, size_t length);
 bool matchingBufferHeader(const u8 *buffer, const u8 *header, size_t length);
 
 
+//
+// Generating pseudo random numbers
+//
+
+/* Advances a xorshift generator and returns the new state. Components that
+ * need random numbers keep a private generator state and use this function
+ * instead of rand(). This keeps multiple emulator instances independent of
+ * each other and makes their output reproducible. The state must not be 0.
+ */
+inline u32 xorshift32(u32 &state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+
 //
 // Computing checksums
 //
@@ -12,11 +12,22 @@
 Oscillator::Oscillator(C64& ref) : C64Component(ref)
 {
     setDescription("Oscillator");
-    
+}
+
 #ifdef __MACH__
-    mach_timebase_info(&tb);
-#endif
+const mach_timebase_info_data_t &
+Oscillator::timebase()
+{
+    // Function-local statics are initialized in a thread-safe way
+    static const mach_timebase_info_data_t tb = [] {
+        mach_timebase_info_data_t info;
+        mach_timebase_info(&info);
+        return info;
+    }();
+    
+    return tb;
 }
+#endif
 
 /*
 const char *
@@ -112,16 +123,17 @@ Oscillator::waitUntil(u64 deadline)
 {
 #ifdef __MACH__
     
-    mach_wait_until(deadline);
+    mach_wait_until(nanos_to_abs(deadline));
     
 #else
 
-    assert(false);
-    // TODO: MISSING IMPLEMENTATION
+    struct timespec ts;
+    ts.tv_sec = deadline / 1000000000;
+    ts.tv_nsec = deadline % 1000000000;
+    
+    // Sleep on the same clock nanos() is reading from
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) { }
     
 #endif
 }
 
-#ifdef __MACH__
-mach_timebase_info_data_t Oscillator::tb;
-#endif
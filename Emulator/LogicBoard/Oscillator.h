@@ -14,20 +14,25 @@
 
 #ifdef __MACH__
 #include <mach/mach_time.h>
+#else
+#include <time.h>
+#include <errno.h>
 #endif
 
 class Oscillator : public C64Component {
     
 #ifdef __MACH__
 
-    // Information about the Mach system timer
-    static mach_timebase_info_data_t tb;
+    /* Returns information about the Mach system timer. The information is
+     * queried once and shared by all instances.
+     */
+    static const mach_timebase_info_data_t &timebase();
 
     // Converts kernel time to nanoseconds
-    static u64 abs_to_nanos(u64 abs) { return abs * tb.numer / tb.denom; }
+    static u64 abs_to_nanos(u64 abs) { return abs * timebase().numer / timebase().denom; }
     
     // Converts nanoseconds to kernel time
-    static u64 nanos_to_abs(u64 nanos) { return nanos * tb.denom / tb.numer; }
+    static u64 nanos_to_abs(u64 nanos) { return nanos * timebase().denom / timebase().numer; }
 
 #endif
     
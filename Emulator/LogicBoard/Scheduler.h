@@ -0,0 +1,100 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#ifndef _SCHEDULER_H
+#define _SCHEDULER_H
+
+#include "Utils.h"
+
+/* Event slots. Each slot belongs to a component that only needs to be
+ * serviced in certain cycles. Primary slots are serviced in the first clock
+ * phase (before the CPU), secondary slots in the second clock phase (after
+ * the CPU). Within a phase, slots are serviced in the listed order.
+ */
+typedef enum
+{
+    // Primary slots
+    EVENT_CIA1,
+    EVENT_CIA2,
+    EVENT_IEC,
+
+    // Secondary slots
+    EVENT_DRIVE8,
+    EVENT_DRIVE9,
+    EVENT_DATASETTE,
+
+    EVENT_SLOT_COUNT
+}
+EventSlot;
+
+// Trigger cycle of an idle slot
+static const Cycle NEVER = INT64_MAX;
+
+/* The scheduler keeps track of the cycles in which the components need to be
+ * serviced. Each component registers the next cycle it is due in its slot.
+ * Components that need to be serviced in every cycle register cycle 0. The
+ * run loop only compares the current cycle with the earliest trigger cycle
+ * of each phase. Hence, idle components don't cost anything.
+ *
+ * The scheduler doesn't store any state on its own. The trigger cycles are
+ * derived from the component states, and each component updates its slot in
+ * _reset() and after a snapshot has been loaded.
+ */
+class Scheduler {
+
+public:
+
+    // Trigger cycle of each slot
+    Cycle trigger[EVENT_SLOT_COUNT];
+
+    // The earliest trigger cycle of all primary and all secondary slots
+    Cycle nextPrimary = NEVER;
+    Cycle nextSecondary = NEVER;
+
+
+    //
+    // Initializing
+    //
+
+public:
+
+    Scheduler() { for (int i = 0; i < EVENT_SLOT_COUNT; i++) trigger[i] = NEVER; }
+
+
+    //
+    // Scheduling events
+    //
+
+public:
+
+    // Checks whether a slot is due in the specified cycle
+    bool isDue(EventSlot s, Cycle cycle) { return cycle >= trigger[s]; }
+
+    // Checks whether a slot is waiting for an event
+    bool isPending(EventSlot s) { return trigger[s] != NEVER; }
+
+    // Registers the cycle in which a component needs to be serviced next
+    void schedule(EventSlot s, Cycle cycle)
+    {
+        trigger[s] = cycle;
+
+        if (s < EVENT_DRIVE8) {
+            nextPrimary = MIN(trigger[EVENT_CIA1],
+                              MIN(trigger[EVENT_CIA2], trigger[EVENT_IEC]));
+        } else {
+            nextSecondary = MIN(trigger[EVENT_DRIVE8],
+                                MIN(trigger[EVENT_DRIVE9], trigger[EVENT_DATASETTE]));
+        }
+    }
+
+    // Marks a slot as idle
+    void cancel(EventSlot s) { schedule(s, NEVER); }
+};
+
+#endif
@@ -9,11 +9,6 @@
 
 #include "C64.h"
 
-#define CHECK_WATCHPOINT(x) \
-if (checkWatchpoints && cpu.debugger.watchpointMatches(x)) { \
-    c64.signalWatchpoint(); \
-}
-
 C64Memory::C64Memory(C64 &ref) : C64Component(ref)
 {	
 	setDescription("C64 memory");
@@ -98,6 +93,7 @@ C64Memory::C64Memory(C64 &ref) : C64Component(ref)
     for (unsigned i = 0x1; i <= 0xF; i++) {
         peekSrc[i] = pokeTarget[i] = M_RAM;
     }
+    updatePagePointers();
 }
 
 void
@@ -109,9 +105,9 @@ C64Memory::_reset()
     eraseWithPattern(config.ramPattern);
         
     // Initialize color RAM with random numbers
-    srand(1000);
+    rngState = 1000;
     for (unsigned i = 0; i < sizeof(colorRam); i++) {
-        colorRam[i] = (rand() & 0xFF);
+        colorRam[i] = (xorshift32(rngState) & 0xFF);
     }
 }
 
@@ -191,6 +187,13 @@ C64Memory::_dump()
 	msg("\n");
 }
 
+size_t
+C64Memory::didLoadFromBuffer(u8 *buffer)
+{
+    updatePagePointers();
+    return 0;
+}
+
 void
 C64Memory::eraseWithPattern(RamPattern pattern)
 {
@@ -229,13 +232,54 @@ C64Memory::updatePeekPokeLookupTables()
     
     // Call the Cartridge's delegation method
     expansionport.updatePeekPokeLookupTables();
+    
+    updatePagePointers();
+}
+
+void
+C64Memory::updatePagePointers()
+{
+    for (unsigned page = 0; page < 256; page++) {
+        
+        switch (peekSrc[page >> 4]) {
+                
+            case M_RAM:
+            case M_PP:
+                peekPage[page] = ram;
+                break;
+                
+            case M_BASIC:
+            case M_CHAR:
+            case M_KERNAL:
+                peekPage[page] = rom;
+                break;
+                
+            default:
+                peekPage[page] = nullptr;
+        }
+        
+        switch (pokeTarget[page >> 4]) {
+                
+            case M_RAM:
+            case M_PP:
+            case M_BASIC:
+            case M_CHAR:
+            case M_KERNAL:
+                pokePage[page] = ram;
+                break;
+                
+            default:
+                pokePage[page] = nullptr;
+        }
+    }
+    
+    // The processor port registers are located in the first page
+    peekPage[0] = pokePage[0] = nullptr;
 }
 
 u8
 C64Memory::peek(u16 addr, MemoryType source)
 {
-    CHECK_WATCHPOINT(addr)
-    
     switch(source) {
         
         case M_RAM:
@@ -284,7 +328,7 @@ C64Memory::peek(u16 addr, bool gameLine, bool exromLine)
 u8
 C64Memory::peekZP(u8 addr)
 {
-    CHECK_WATCHPOINT(addr)
+    countAccess(HEAT_READ, addr, peekSrc[0]);
     
     if (likely(addr >= 0x02)) {
         return ram[addr];
@@ -298,16 +342,13 @@ C64Memory::peekZP(u8 addr)
 u8
 C64Memory::peekStack(u8 sp)
 {
-    CHECK_WATCHPOINT(sp)
-    
+    countAccess(HEAT_READ, 0x100 + sp, peekSrc[0]);
     return ram[0x100 + sp];
 }
 
 u8
 C64Memory::peekIO(u16 addr)
 {
-    CHECK_WATCHPOINT(addr)
-    
     assert(addr >= 0xD000 && addr <= 0xDFFF);
     
     switch ((addr >> 8) & 0xF) {
@@ -345,6 +386,8 @@ C64Memory::peekIO(u16 addr)
 	
         case 0xD: // CIA 2
             
+            // Port A reflects the IEC bus. Lazy drives need to catch up first
+            if ((addr & 0x000F) == 0x00) iec.catchUpDrives(cpu.cycle - 1);
             return cia2.peek(addr & 0x000F);
             
         case 0xE: // I/O space 1
@@ -447,8 +490,6 @@ C64Memory::spypeekColor(u16 addr)
 void
 C64Memory::poke(u16 addr, u8 value, MemoryType target)
 {
-    CHECK_WATCHPOINT(addr)
-    
     switch(target) {
             
         case M_RAM:
@@ -499,7 +540,7 @@ C64Memory::poke(u16 addr, u8 value, bool gameLine, bool exromLine)
 void
 C64Memory::pokeZP(u8 addr, u8 value)
 {
-    CHECK_WATCHPOINT(addr)
+    countAccess(HEAT_WRITE, addr, pokeTarget[0]);
     
     if (likely(addr >= 0x02)) {
         ram[addr] = value;
@@ -513,16 +554,13 @@ C64Memory::pokeZP(u8 addr, u8 value)
 void
 C64Memory::pokeStack(u8 sp, u8 value)
 {
-    CHECK_WATCHPOINT(sp)
-    
+    countAccess(HEAT_WRITE, 0x100 + sp, pokeTarget[0]);
     ram[0x100 + sp] = value;
 }
 
 void
 C64Memory::pokeIO(u16 addr, u8 value)
 {
-    CHECK_WATCHPOINT(addr)
-    
     assert(addr >= 0xD000 && addr <= 0xDFFF);
     
     switch ((addr >> 8) & 0xF) {
@@ -559,7 +597,7 @@ C64Memory::pokeIO(u16 addr, u8 value)
         case 0xA: // Color RAM
         case 0xB: // Color RAM
             
-            colorRam[addr - 0xD800] = (value & 0x0F) | (rand() & 0xF0);
+            colorRam[addr - 0xD800] = (value & 0x0F) | (xorshift32(rngState) & 0xF0);
             return;
             
         case 0xC: // CIA 1
@@ -621,7 +659,7 @@ C64Memory::resetVector() {
 char *
 C64Memory::memdump(u16 addr, long num, bool hex, MemoryType src)
 {
-    static char result[128];
+    char *result = memdumpStr;
     char *p = result;
     
     assert(num <= 16);
@@ -659,7 +697,7 @@ C64Memory::memdump(u16 addr, long num, bool hex, MemoryType src)
 char *
 C64Memory::txtdump(u16 addr, long num, MemoryType src)
 {
-    static char result[17];
+    char *result = txtdumpStr;
     char *p = result;
     
     assert(num <= 16);
@@ -681,3 +719,16 @@ C64Memory::txtdump(u16 addr, long num, MemoryType src)
 
     return result;
 }
+
+bool
+C64Memory::setHeatmapRecording(bool enable)
+{
+    if (!MEM_HEATMAP) return false;
+    
+    suspend();
+    if (enable && !heatmap) heatmap = new MemHeatmap();
+    recordingHeatmap = enable;
+    resume();
+    
+    return true;
+}
@@ -11,6 +11,7 @@
 #define _C64MEMORY_H
 
 #include "C64Memory.h"
+#include "MemHeatmap.h"
 
 class C64Memory : public C64Component {
 
@@ -55,8 +56,29 @@ public:
     // Poke target lookup table
     MemoryType pokeTarget[16];
     
-    // Indicates if watchpoints should be checked
-    bool checkWatchpoints = false;
+    /* Page pointer tables
+     * For each 256 byte page, these tables point to the array that is read or
+     * written if the page is accessed by the CPU (ram or rom, both indexed by
+     * the full address). Pages with side effects (I/O, cartridge, processor
+     * port) are mapped to nullptr and take the slow path via the lookup
+     * tables above. The tables are derived from the lookup tables in
+     * updatePeekPokeLookupTables().
+     */
+    u8 *peekPage[256];
+    u8 *pokePage[256];
+    
+    /* Memory heatmap (created when recording is enabled for the first time).
+     * The recording hooks are only compiled in if MEM_HEATMAP is set.
+     */
+    MemHeatmap *heatmap = nullptr;
+    bool recordingHeatmap = false;
+    
+    // Random number generator state (used for the open color RAM bits)
+    u32 rngState = 1000;
+    
+    // Result buffers of memdump() and txtdump()
+    char memdumpStr[128];
+    char txtdumpStr[17];
     
     
     //
@@ -66,6 +88,7 @@ public:
 public:
     
 	C64Memory(C64 &ref);
+    ~C64Memory() { delete heatmap; }
     
 private:
     
@@ -128,6 +151,7 @@ private:
     size_t _size() override { COMPUTE_SNAPSHOT_SIZE }
     size_t _load(u8 *buffer) override { LOAD_SNAPSHOT_ITEMS }
     size_t _save(u8 *buffer) override { SAVE_SNAPSHOT_ITEMS }
+    size_t didLoadFromBuffer(u8 *buffer) override;
     
     
     //
@@ -143,6 +167,13 @@ public:
      * three processor port bits and the cartridge exrom and game lines.
      */
     void updatePeekPokeLookupTables();
+    
+private:
+    
+    // Derives the page pointer tables from the peek and poke lookup tables
+    void updatePagePointers();
+    
+public:
 
     // Returns the current peek source of the specified memory address
     MemoryType getPeekSource(u16 addr) { return peekSrc[addr >> 12]; }
@@ -153,7 +184,10 @@ public:
     // Reads a value from memory
     u8 peek(u16 addr, MemoryType source);
     u8 peek(u16 addr, bool gameLine, bool exromLine);
-    u8 peek(u16 addr) { return peek(addr, peekSrc[addr >> 12]); }
+    u8 peek(u16 addr) {
+        countAccess(HEAT_READ, addr, peekSrc[addr >> 12]);
+        if (u8 *page = peekPage[addr >> 8]) return page[addr];
+        return peek(addr, peekSrc[addr >> 12]); }
     u8 peekZP(u8 addr);
     u8 peekStack(u8 sp);
     u8 peekIO(u16 addr);
@@ -173,7 +207,13 @@ public:
     // Writing a value into memory
     void poke(u16 addr, u8 value, MemoryType target);
     void poke(u16 addr, u8 value, bool gameLine, bool exromLine);
-    void poke(u16 addr, u8 value) { poke(addr, value, pokeTarget[addr >> 12]); }
+    void poke(u16 addr, u8 value) {
+        countAccess(HEAT_WRITE, addr, pokeTarget[addr >> 12]);
+        if (u8 *page = pokePage[addr >> 8]) {
+            page[addr] = value;
+            return;
+        }
+        poke(addr, value, pokeTarget[addr >> 12]); }
     void pokeZP(u8 addr, u8 value);
     void pokeStack(u8 sp, u8 value);
     void pokeIO(u16 addr, u8 value);
@@ -193,6 +233,24 @@ public:
     char *hexdump(u16 addr, long num) { return hexdump(addr, num, peekSrc[addr >> 12]); }
     char *decdump(u16 addr, long num) { return decdump(addr, num, peekSrc[addr >> 12]); }
     char *txtdump(u16 addr, long num) { return txtdump(addr, num, peekSrc[addr >> 12]); }
+    
+    
+    //
+    // Recording the heatmap
+    //
+    
+public:
+    
+    /* Starts or stops recording the heatmap. The recorded data is kept when
+     * recording is stopped. Returns false if the emulator has been compiled
+     * without heatmap support.
+     */
+    bool setHeatmapRecording(bool enable);
+    
+    // Counts a memory access (called by the CPU and the VICII)
+    void countAccess(HeatAccess access, u16 addr, MemoryType type) {
+        if (MEM_HEATMAP && recordingHeatmap) heatmap->record(access, addr, type);
+    }
 };
 
 #endif
@@ -0,0 +1,141 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "C64.h"
+
+#include <math.h>
+
+static const char *accessName[HEAT_COUNT] = { "read", "write", "exec", "vic" };
+
+static const char *typeName[M_NONE + 1] = {
+    nullptr, "ram", "char", "kernal", "basic", "io", "crtlo", "crthi", "pp", "none"
+};
+
+// Closes a file and returns false if a write or the close has failed
+static bool
+closeFile(FILE *file)
+{
+    bool success = !ferror(file);
+    return fclose(file) == 0 && success;
+}
+
+void
+MemHeatmap::clear()
+{
+    memset(total, 0, sizeof(total));
+    memset(counts, 0, sizeof(counts));
+    memset(&summary, 0, sizeof(summary));
+
+    timeline.clear();
+    frames = 0;
+}
+
+void
+MemHeatmap::endFrame()
+{
+    for (unsigned i = 0; i < HEAT_COUNT; i++) {
+        for (unsigned addr = 0; addr < 0x10000; addr++) {
+            total[i][addr] += counts[current][i][addr];
+        }
+    }
+    timeline.push_back(summary);
+    frames++;
+
+    // The finished frame becomes the last frame
+    current ^= 1;
+    memset(counts[current], 0, sizeof(counts[current]));
+    memset(&summary, 0, sizeof(summary));
+}
+
+bool
+MemHeatmap::writeImage(const char *path)
+{
+    FILE *file = fopen(path, "wb");
+    if (!file) return false;
+
+    // Determine the scaling factor of each channel
+    std::vector<u64> cpu(0x10000);
+    u64 max[3] = { 1, 1, 1 };
+    for (unsigned addr = 0; addr < 0x10000; addr++) {
+        cpu[addr] = total[HEAT_READ][addr] + total[HEAT_WRITE][addr];
+        max[0] = std::max(max[0], cpu[addr]);
+        max[1] = std::max(max[1], total[HEAT_VIC][addr]);
+        max[2] = std::max(max[2], total[HEAT_EXEC][addr]);
+    }
+    auto scale = [](u64 value, u64 max) {
+        return (u8)(255.0 * log1p((double)value) / log1p((double)max));
+    };
+
+    fprintf(file, "P6\n256 256\n255\n");
+    for (unsigned addr = 0; addr < 0x10000; addr++) {
+        u8 rgb[3] = {
+            scale(cpu[addr], max[0]),
+            scale(total[HEAT_VIC][addr], max[1]),
+            scale(total[HEAT_EXEC][addr], max[2])
+        };
+        fwrite(rgb, 1, 3, file);
+    }
+
+    return closeFile(file);
+}
+
+bool
+MemHeatmap::writePages(const char *path)
+{
+    FILE *file = fopen(path, "w");
+    if (!file) return false;
+
+    fprintf(file, "page");
+    for (unsigned i = 0; i < HEAT_COUNT; i++) fprintf(file, ",%s", accessName[i]);
+    fprintf(file, "\n");
+
+    for (unsigned page = 0; page < 0x100; page++) {
+
+        fprintf(file, "%02X", page);
+        for (unsigned i = 0; i < HEAT_COUNT; i++) {
+
+            u64 sum = 0;
+            for (unsigned addr = page << 8; addr < (page + 1) << 8; addr++) {
+                sum += total[i][addr];
+            }
+            fprintf(file, ",%llu", sum);
+        }
+        fprintf(file, "\n");
+    }
+
+    return closeFile(file);
+}
+
+bool
+MemHeatmap::writeTimeline(const char *path)
+{
+    FILE *file = fopen(path, "w");
+    if (!file) return false;
+
+    fprintf(file, "frame");
+    for (unsigned i = 0; i < HEAT_COUNT; i++) {
+        for (unsigned type = M_RAM; type <= M_NONE; type++) {
+            fprintf(file, ",%s_%s", accessName[i], typeName[type]);
+        }
+    }
+    fprintf(file, "\n");
+
+    for (size_t frame = 0; frame < timeline.size(); frame++) {
+
+        fprintf(file, "%zu", frame);
+        for (unsigned i = 0; i < HEAT_COUNT; i++) {
+            for (unsigned type = M_RAM; type <= M_NONE; type++) {
+                fprintf(file, ",%u", timeline[frame].count[i][type]);
+            }
+        }
+        fprintf(file, "\n");
+    }
+
+    return closeFile(file);
+}
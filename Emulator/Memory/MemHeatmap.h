@@ -0,0 +1,110 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#ifndef _MEM_HEATMAP_H
+#define _MEM_HEATMAP_H
+
+#include "Aliases.h"
+#include "MemoryTypes.h"
+
+#include <vector>
+
+/* The memory heatmap counts the bus accesses of the CPU and the VICII. The
+ * CPU side is fed by the peek and poke functions of C64Memory, the VICII
+ * side by VICII::memAccess(). Each access is counted twice: Once per address
+ * (the address as seen on the bus) and once per memory type (as determined
+ * by the current bank map).
+ *
+ * Counters are kept for the frame in progress, the last completed frame, and
+ * all completed frames so far. The per-type counts are additionally stored
+ * for each frame which allows to follow bank switching over time.
+ *
+ * The heatmap is an instrumentation feature. The hooks are only compiled in
+ * if MEM_HEATMAP is set to 1 (see C64Config.h).
+ */
+class MemHeatmap {
+
+public:
+
+    // Number of completed frames
+    u64 frames = 0;
+
+    // Per-address counts of all completed frames
+    u64 total[HEAT_COUNT][0x10000];
+
+    // Per-type counts, one entry for each completed frame
+    std::vector<HeatFrame> timeline;
+
+private:
+
+    // Per-address counts of the frame in progress and the last frame
+    u32 counts[2][HEAT_COUNT][0x10000];
+    int current = 0;
+
+    // Per-type counts of the frame in progress
+    HeatFrame summary;
+
+
+    //
+    // Initializing
+    //
+
+public:
+
+    MemHeatmap() { clear(); }
+
+    // Deletes all recorded data
+    void clear();
+
+
+    //
+    // Recording
+    //
+
+public:
+
+    void record(HeatAccess access, u16 addr, MemoryType type) {
+
+        counts[current][access][addr]++;
+        summary.count[access][type]++;
+    }
+
+    // Completes the current frame
+    void endFrame();
+
+
+    //
+    // Analyzing
+    //
+
+public:
+
+    // Returns the per-address counts of the last completed frame
+    const u32 *lastFrame(HeatAccess access) { return counts[current ^ 1][access]; }
+
+    /* The following functions return false if the file cannot be created or
+     * written completely.
+     */
+    
+    /* Writes the accumulated counts as a 256 x 256 pixel image in PPM format.
+     * Each row represents a memory page. Red shows CPU reads and writes,
+     * green shows VICII reads, and blue shows executed opcodes. Each channel
+     * is scaled logarithmically. Cells accessed by the CPU and the VICII
+     * appear in yellow.
+     */
+    bool writeImage(const char *path);
+
+    // Writes the accumulated counts of each page as CSV
+    bool writePages(const char *path);
+
+    // Writes the per-type counts of each frame as CSV
+    bool writeTimeline(const char *path);
+};
+
+#endif
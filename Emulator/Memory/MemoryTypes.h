@@ -42,6 +42,17 @@ inline bool isRamPattern(long value)
     return value == RAM_PATTERN_C64 || value == RAM_PATTERN_C64C;
 }
 
+// Access types distinguished by the memory heatmap (see MemHeatmap)
+typedef enum
+{
+    HEAT_READ = 0,  // CPU read (including opcode fetches and idle reads)
+    HEAT_WRITE,     // CPU write
+    HEAT_EXEC,      // CPU opcode fetch
+    HEAT_VIC,       // VICII read
+    HEAT_COUNT
+}
+HeatAccess;
+
 //
 // Structures
 //
@@ -53,6 +64,13 @@ typedef struct
 }
 MemConfig;
 
+// Number of memory accesses in a single frame, grouped by memory type
+typedef struct
+{
+    u32 count[HEAT_COUNT][M_NONE + 1];
+}
+HeatFrame;
+
 typedef struct
 {
     bool exrom;
@@ -9,6 +9,23 @@
 
 #include "C64.h"
 
+/* reSID computes its waveform, DAC, and filter tables when the first object
+ * is created and stores them in static class members. To make it safe to
+ * create emulator instances in parallel threads, all reSID objects are
+ * created while holding this lock.
+ */
+static pthread_mutex_t sidCreationLock = PTHREAD_MUTEX_INITIALIZER;
+
+static reSID::SID *
+createSID()
+{
+    pthread_mutex_lock(&sidCreationLock);
+    reSID::SID *result = new reSID::SID();
+    pthread_mutex_unlock(&sidCreationLock);
+    
+    return result;
+}
+
 ReSID::ReSID(C64 &ref, SIDBridge &bridgeref) : C64Component(ref), bridge(bridgeref)
 {
 	setDescription("ReSID");
@@ -17,7 +34,7 @@ ReSID::ReSID(C64 &ref, SIDBridge &bridgeref) : C64Component(ref), bridge(bridger
     emulateFilter = true;
     sampleRate = 44100;
 
-    sid = new reSID::SID();
+    sid = createSID();
     sid->set_chip_model(reSID::MOS6581);
     sid->set_sampling_parameters((double)PAL_CLOCK_FREQUENCY,
                                  reSID::SAMPLE_FAST,
@@ -41,7 +58,7 @@ ReSID::_reset()
     // reSID::reset() because it only performs a soft reset.
 
     delete sid;
-    sid = new reSID::SID();
+    sid = createSID();
     
     sid->set_chip_model((reSID::chip_model)model);
     sid->set_sampling_parameters((double)clockFrequency,
@@ -41,8 +41,9 @@ FastSID::FastSID(C64 &ref, SIDBridge &bridgeref) : C64Component(ref), bridge(bri
         &voice[2]
     };
     
-    // Initialize wave and noise tables
-    FastVoice::initWaveTables();
+    // Initialize wave and noise tables (shared by all instances)
+    static pthread_once_t waveTablesInitialized = PTHREAD_ONCE_INIT;
+    pthread_once(&waveTablesInitialized, FastVoice::initWaveTables);
     
     // Initialize voices
     voice[0].init(this, 0, &voice[3]);
@@ -273,14 +274,14 @@ FastSID::peek(u16 addr)
             // This register allows the microprocessor to read the
             // upper 8 output bits of oscillator 3.
             // return (u8)(voice[2].doosc() >> 7);
-            return (u8)rand();
+            return (u8)xorshift32(rngState);
 
         case 0x1C:
             
             // This register allows the microprocessor to read the
             // output of the voice 3 envelope generator.
             // return (u8)(voice[2].adsr >> 23);
-            return (u8)rand();
+            return (u8)xorshift32(rngState);
             
         default:
             
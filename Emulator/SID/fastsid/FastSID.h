@@ -81,6 +81,9 @@ private:
     // Last value on the data bus
     u8 latchedDataBus;
     
+    // Random number generator state (used for the OSC3 and ENV3 registers)
+    u32 rngState = 1;
+    
 public:
     
     // ADSR counter step lookup table
@@ -0,0 +1,362 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "C64.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define PIXEL_CONVERTER_X86
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define PIXEL_CONVERTER_NEON
+#include <arm_neon.h>
+#endif
+
+/* Each of the vector functions below converts a multiple of its vector width
+ * and returns the number of converted pixels. The remaining pixels are left
+ * to the scalar loop. 'planes' contains the bytes of the output pixels in
+ * memory order (byte 0 is written first).
+ */
+
+#ifdef PIXEL_CONVERTER_X86
+
+__attribute__((target("avx2"))) static size_t
+expand32AVX2(const u8 (*planes)[16], const u8 *src, u8 *dst, size_t count)
+{
+    const __m256i mask = _mm256_set1_epi8(0x0F);
+    __m256i p[4];
+    for (int k = 0; k < 4; k++) {
+        p[k] = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)planes[k]));
+    }
+
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+
+        __m256i idx = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(src + i)), mask);
+
+        // Look up the four bytes of 32 pixels
+        __m256i b0 = _mm256_shuffle_epi8(p[0], idx);
+        __m256i b1 = _mm256_shuffle_epi8(p[1], idx);
+        __m256i b2 = _mm256_shuffle_epi8(p[2], idx);
+        __m256i b3 = _mm256_shuffle_epi8(p[3], idx);
+
+        // Interleave (each 128-bit lane is interleaved separately)
+        __m256i t0 = _mm256_unpacklo_epi8(b0, b1);
+        __m256i t1 = _mm256_unpackhi_epi8(b0, b1);
+        __m256i t2 = _mm256_unpacklo_epi8(b2, b3);
+        __m256i t3 = _mm256_unpackhi_epi8(b2, b3);
+        __m256i q0 = _mm256_unpacklo_epi16(t0, t2);     // Pixels 0 - 3, 16 - 19
+        __m256i q1 = _mm256_unpackhi_epi16(t0, t2);     // Pixels 4 - 7, 20 - 23
+        __m256i q2 = _mm256_unpacklo_epi16(t1, t3);     // Pixels 8 - 11, 24 - 27
+        __m256i q3 = _mm256_unpackhi_epi16(t1, t3);     // Pixels 12 - 15, 28 - 31
+
+        // Put the lanes in order
+        __m256i *out = (__m256i *)(dst + 4 * i);
+        _mm256_storeu_si256(out + 0, _mm256_permute2x128_si256(q0, q1, 0x20));
+        _mm256_storeu_si256(out + 1, _mm256_permute2x128_si256(q2, q3, 0x20));
+        _mm256_storeu_si256(out + 2, _mm256_permute2x128_si256(q0, q1, 0x31));
+        _mm256_storeu_si256(out + 3, _mm256_permute2x128_si256(q2, q3, 0x31));
+    }
+    return i;
+}
+
+__attribute__((target("avx2"))) static size_t
+expand16AVX2(const u8 (*planes)[16], const u8 *src, u8 *dst, size_t count)
+{
+    const __m256i mask = _mm256_set1_epi8(0x0F);
+    __m256i p0 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)planes[0]));
+    __m256i p1 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)planes[1]));
+
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+
+        __m256i idx = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(src + i)), mask);
+        __m256i b0 = _mm256_shuffle_epi8(p0, idx);
+        __m256i b1 = _mm256_shuffle_epi8(p1, idx);
+        __m256i t0 = _mm256_unpacklo_epi8(b0, b1);      // Pixels 0 - 7, 16 - 23
+        __m256i t1 = _mm256_unpackhi_epi8(b0, b1);      // Pixels 8 - 15, 24 - 31
+
+        __m256i *out = (__m256i *)(dst + 2 * i);
+        _mm256_storeu_si256(out + 0, _mm256_permute2x128_si256(t0, t1, 0x20));
+        _mm256_storeu_si256(out + 1, _mm256_permute2x128_si256(t0, t1, 0x31));
+    }
+    return i;
+}
+
+__attribute__((target("ssse3"))) static size_t
+expand32SSSE3(const u8 (*planes)[16], const u8 *src, u8 *dst, size_t count)
+{
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    __m128i p[4];
+    for (int k = 0; k < 4; k++) {
+        p[k] = _mm_loadu_si128((const __m128i *)planes[k]);
+    }
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+
+        __m128i idx = _mm_and_si128(_mm_loadu_si128((const __m128i *)(src + i)), mask);
+        __m128i b0 = _mm_shuffle_epi8(p[0], idx);
+        __m128i b1 = _mm_shuffle_epi8(p[1], idx);
+        __m128i b2 = _mm_shuffle_epi8(p[2], idx);
+        __m128i b3 = _mm_shuffle_epi8(p[3], idx);
+        __m128i t0 = _mm_unpacklo_epi8(b0, b1);
+        __m128i t1 = _mm_unpackhi_epi8(b0, b1);
+        __m128i t2 = _mm_unpacklo_epi8(b2, b3);
+        __m128i t3 = _mm_unpackhi_epi8(b2, b3);
+
+        __m128i *out = (__m128i *)(dst + 4 * i);
+        _mm_storeu_si128(out + 0, _mm_unpacklo_epi16(t0, t2));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(t0, t2));
+        _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(t1, t3));
+        _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(t1, t3));
+    }
+    return i;
+}
+
+__attribute__((target("ssse3"))) static size_t
+expand16SSSE3(const u8 (*planes)[16], const u8 *src, u8 *dst, size_t count)
+{
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    __m128i p0 = _mm_loadu_si128((const __m128i *)planes[0]);
+    __m128i p1 = _mm_loadu_si128((const __m128i *)planes[1]);
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+
+        __m128i idx = _mm_and_si128(_mm_loadu_si128((const __m128i *)(src + i)), mask);
+        __m128i b0 = _mm_shuffle_epi8(p0, idx);
+        __m128i b1 = _mm_shuffle_epi8(p1, idx);
+
+        __m128i *out = (__m128i *)(dst + 2 * i);
+        _mm_storeu_si128(out + 0, _mm_unpacklo_epi8(b0, b1));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi8(b0, b1));
+    }
+    return i;
+}
+
+#endif
+
+#ifdef PIXEL_CONVERTER_NEON
+
+static size_t
+expand32NEON(const u8 (*planes)[16], const u8 *src, u8 *dst, size_t count)
+{
+    const uint8x16_t mask = vdupq_n_u8(0x0F);
+    uint8x16_t p0 = vld1q_u8(planes[0]);
+    uint8x16_t p1 = vld1q_u8(planes[1]);
+    uint8x16_t p2 = vld1q_u8(planes[2]);
+    uint8x16_t p3 = vld1q_u8(planes[3]);
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+
+        uint8x16_t idx = vandq_u8(vld1q_u8(src + i), mask);
+        uint8x16x4_t pixels;
+        pixels.val[0] = vqtbl1q_u8(p0, idx);
+        pixels.val[1] = vqtbl1q_u8(p1, idx);
+        pixels.val[2] = vqtbl1q_u8(p2, idx);
+        pixels.val[3] = vqtbl1q_u8(p3, idx);
+
+        // Store interleaved
+        vst4q_u8(dst + 4 * i, pixels);
+    }
+    return i;
+}
+
+static size_t
+expand16NEON(const u8 (*planes)[16], const u8 *src, u8 *dst, size_t count)
+{
+    const uint8x16_t mask = vdupq_n_u8(0x0F);
+    uint8x16_t p0 = vld1q_u8(planes[0]);
+    uint8x16_t p1 = vld1q_u8(planes[1]);
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+
+        uint8x16_t idx = vandq_u8(vld1q_u8(src + i), mask);
+        uint8x16x2_t pixels;
+        pixels.val[0] = vqtbl1q_u8(p0, idx);
+        pixels.val[1] = vqtbl1q_u8(p1, idx);
+
+        vst2q_u8(dst + 2 * i, pixels);
+    }
+    return i;
+}
+
+#endif
+
+PixelConverter::PixelConverter()
+{
+    selectKernel(bestKernel());
+
+    u32 gray[16];
+    for (unsigned i = 0; i < 16; i++) gray[i] = LO_LO_HI_HI(i * 17, i * 17, i * 17, 0xFF);
+    setPalette(gray);
+}
+
+bool
+PixelConverter::isSupported(PixelKernel kernel)
+{
+    switch (kernel) {
+
+        case PIXEL_KERNEL_SCALAR: return true;
+#if defined(PIXEL_CONVERTER_X86)
+        case PIXEL_KERNEL_SSSE3: return __builtin_cpu_supports("ssse3");
+        case PIXEL_KERNEL_AVX2: return __builtin_cpu_supports("avx2");
+#elif defined(PIXEL_CONVERTER_NEON)
+        case PIXEL_KERNEL_NEON: return true;
+#endif
+        default: return false;
+    }
+}
+
+PixelKernel
+PixelConverter::bestKernel()
+{
+    // Initialized on first use (thread-safe in C++11 and later)
+    static const PixelKernel best = []() {
+        
+        for (PixelKernel k : { PIXEL_KERNEL_AVX2, PIXEL_KERNEL_NEON, PIXEL_KERNEL_SSSE3 }) {
+            if (isSupported(k)) return k;
+        }
+        return PIXEL_KERNEL_SCALAR;
+    }();
+    
+    return best;
+}
+
+void
+PixelConverter::selectKernel(PixelKernel kernel)
+{
+    assert(isPixelKernel(kernel));
+    assert(isSupported(kernel));
+    
+    this->kernel = kernel;
+    expand32 = nullptr;
+    expand16 = nullptr;
+    
+    switch (kernel) {
+            
+#if defined(PIXEL_CONVERTER_X86)
+        case PIXEL_KERNEL_SSSE3:
+            expand32 = expand32SSSE3;
+            expand16 = expand16SSSE3;
+            break;
+            
+        case PIXEL_KERNEL_AVX2:
+            expand32 = expand32AVX2;
+            expand16 = expand16AVX2;
+            break;
+#elif defined(PIXEL_CONVERTER_NEON)
+        case PIXEL_KERNEL_NEON:
+            expand32 = expand32NEON;
+            expand16 = expand16NEON;
+            break;
+#endif
+        default:
+            break;
+    }
+}
+
+void
+PixelConverter::setPalette(const u32 *palette)
+{
+    for (unsigned i = 0; i < 16; i++) {
+
+        u8 r = palette[i] & 0xFF;
+        u8 g = (palette[i] >> 8) & 0xFF;
+        u8 b = (palette[i] >> 16) & 0xFF;
+        u8 a = (palette[i] >> 24) & 0xFF;
+
+        rgba[i] = LO_LO_HI_HI(r, g, b, a);
+        bgra[i] = LO_LO_HI_HI(b, g, r, a);
+        rgb565[i] = (u16)((r >> 3) << 11 | (g >> 2) << 5 | (b >> 3));
+
+        for (unsigned k = 0; k < 4; k++) {
+            planes[PIXEL_RGBA][k][i] = (u8)(rgba[i] >> (8 * k));
+            planes[PIXEL_BGRA][k][i] = (u8)(bgra[i] >> (8 * k));
+            planes[PIXEL_RGB565][k][i] = k < 2 ? (u8)(rgb565[i] >> (8 * k)) : 0;
+        }
+    }
+}
+
+void
+PixelConverter::convert(const u8 *src, void *dst, size_t count, PixelFormat format)
+{
+    assert(isPixelFormat(format));
+
+    size_t i = 0;
+
+    if (format == PIXEL_RGB565) {
+
+        u16 *target = (u16 *)dst;
+        if (expand16) i = expand16(planes[format], src, (u8 *)target, count);
+        for (; i < count; i++) target[i] = rgb565[src[i] & 0xF];
+
+    } else {
+
+        const u32 *table = format == PIXEL_RGBA ? rgba : bgra;
+        u32 *target = (u32 *)dst;
+        if (expand32) i = expand32(planes[format], src, (u8 *)target, count);
+        for (; i < count; i++) target[i] = table[src[i] & 0xF];
+    }
+}
+
+void
+PixelConverter::convert(const u8 *src, void *dst, PixelFormat format,
+                        long x, long y, long width, long height)
+{
+    assert(x >= 0 && width >= 0 && x + width <= TEX_WIDTH);
+    assert(y >= 0 && height >= 0 && y + height <= TEX_HEIGHT);
+
+    src += y * TEX_WIDTH + x;
+
+    // Convert entire rows in a single pass
+    if (width == TEX_WIDTH) {
+        convert(src, dst, (size_t)(width * height), format);
+        return;
+    }
+
+    u8 *target = (u8 *)dst;
+    size_t pitch = width * bytesPerPixel(format);
+    for (long i = 0; i < height; i++, src += TEX_WIDTH, target += pitch) {
+        convert(src, target, (size_t)width, format);
+    }
+}
+
+void
+PixelConverter::convert(const u32 *src, void *dst, size_t count, PixelFormat format)
+{
+    assert(isPixelFormat(format));
+
+    switch (format) {
+            
+        case PIXEL_RGBA:
+            
+            memcpy(dst, src, count * sizeof(u32));
+            break;
+            
+        case PIXEL_BGRA:
+            
+            for (size_t i = 0; i < count; i++) {
+                u32 c = src[i];
+                ((u32 *)dst)[i] = (c & 0xFF00FF00) | (c >> 16 & 0xFF) | (c & 0xFF) << 16;
+            }
+            break;
+            
+        default:
+            
+            for (size_t i = 0; i < count; i++) {
+                u32 c = src[i];
+                u8 r = c & 0xFF, g = (c >> 8) & 0xFF, b = (c >> 16) & 0xFF;
+                ((u16 *)dst)[i] = (u16)((r >> 3) << 11 | (g >> 2) << 5 | (b >> 3));
+            }
+            break;
+    }
+}
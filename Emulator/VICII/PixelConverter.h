@@ -0,0 +1,83 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#ifndef _PIXEL_CONVERTER_H
+#define _PIXEL_CONVERTER_H
+
+#include "Aliases.h"
+#include "VICIITypes.h"
+
+#include <stddef.h>
+
+/* The pixel converter expands C64 color indices into RGBA, BGRA or RGB565
+ * values. It is used to turn the index textures written by the VICII into
+ * displayable images.
+ *
+ * Because there are only 16 colors, each byte of an output pixel can be
+ * looked up with a single 16-entry byte shuffle. The vector code shuffles
+ * one byte plane per output byte and interleaves the planes afterwards. On
+ * x86, the AVX2 or the SSSE3 variant is selected at runtime. On ARM, NEON is
+ * used. All other targets and the remaining pixels of each call are handled
+ * by the scalar loop.
+ */
+class PixelConverter {
+
+    typedef size_t (*ExpandFunc)(const u8 (*)[16], const u8 *, u8 *, size_t);
+
+    // The selected kernel and its vector functions (nullptr for scalar)
+    PixelKernel kernel = PIXEL_KERNEL_SCALAR;
+    ExpandFunc expand32 = nullptr;
+    ExpandFunc expand16 = nullptr;
+
+    // Lookup tables, indexed by the C64 color
+    u32 rgba[16];
+    u32 bgra[16];
+    u16 rgb565[16];
+
+    // The same tables split into byte planes (used by the vector code)
+    u8 planes[3][4][16];
+
+public:
+
+    PixelConverter();
+
+    // Sets up the lookup tables for a palette given in RGBA format
+    void setPalette(const u32 *palette);
+
+    // Checks if a kernel is compiled in and supported by the host CPU
+    static bool isSupported(PixelKernel kernel);
+
+    // Returns the fastest supported kernel (determined once)
+    static PixelKernel bestKernel();
+
+    // Selects a kernel (the constructor selects the fastest one)
+    void selectKernel(PixelKernel kernel);
+    PixelKernel getKernel() { return kernel; }
+
+    // Returns the size of a single pixel in bytes
+    static size_t bytesPerPixel(PixelFormat format) {
+        return format == PIXEL_RGB565 ? 2 : 4;
+    }
+
+    // Converts 'count' consecutive color indices
+    void convert(const u8 *src, void *dst, size_t count, PixelFormat format);
+
+    /* Converts a rectangular area of a texture with TEX_WIDTH indices per
+     * row. The target area is written without gaps, i.e., a row of the target
+     * has 'width' pixels. If the area covers entire rows, it is converted in
+     * a single pass.
+     */
+    void convert(const u8 *src, void *dst, PixelFormat format,
+                 long x, long y, long width, long height);
+
+    // Converts 'count' RGBA values into the requested pixel format
+    static void convert(const u32 *src, void *dst, size_t count, PixelFormat format);
+};
+
+#endif
@@ -47,22 +47,45 @@ VICII::VICII(C64 &ref) : C64Component(ref)
     baLine.setClock(&cpu.cycle);
     gAccessResult.setClock(&cpu.cycle);
     
+    // Allocate texture buffers
+    for (int i = 0; i < 3; i++) {
+        emuTextures[i] = new int[TEX_HEIGHT * TEX_WIDTH];
+        dmaTextures[i] = new int[TEX_HEIGHT * TEX_WIDTH];
+        idxTextures[i] = new u8[TEX_HEIGHT * TEX_WIDTH]();
+    }
+    
     // Create random background noise pattern
     const size_t noiseSize = 2 * 512 * 512;
     noise = new u32[noiseSize];
     for (size_t i = 0; i < noiseSize; i++) {
-        noise[i] = rand() % 2 ? 0xFF000000 : 0xFFFFFFFF;
+        noise[i] = xorshift32(noiseState) % 2 ? 0xFF000000 : 0xFFFFFFFF;
     }
 }
 
+VICII::~VICII()
+{
+    for (int i = 0; i < 3; i++) {
+        delete [] emuTextures[i];
+        delete [] dmaTextures[i];
+        delete [] idxTextures[i];
+    }
+    delete [] noise;
+}
+
 void
 VICII::_initialize()
 {
     setRevision(PAL_8565);
     
+    // The consumer isn't running yet, so its buffer can be reset, too
+    resetEmuTexture(stableBuffer);
+    resetDmaTexture(stableBuffer);
+    
     config.hideSprites = false;
     config.checkSBCollisions = true;
     config.checkSSCollisions = true;
+    config.renderInterval = 1;
+    config.framebuffer = FRAMEBUFFER_RGBA;
 }
 
 void 
@@ -94,16 +117,21 @@ VICII::_reset()
     upperComparisonVal = upperComparisonValue();
     lowerComparisonVal = lowerComparisonValue();
         
-    // Reset the screen buffer pointers
-    emuTexture = emuTexturePtr = emuTexture1;
-    dmaTexture = dmaTexturePtr = dmaTexture1;
+    /* Reset the screen buffer pointers. The buffer assignment is kept,
+     * because the consumer may access the stable buffer concurrently.
+     */
+    skipFrame = false;
+    emuTexture = emuTexturePtr = emuTextures[workingBuffer];
+    dmaTexture = dmaTexturePtr = dmaTextures[workingBuffer];
+    idxTexture = idxTexturePtr = idxTextures[workingBuffer];
+    rowCount[workingBuffer] = 0;
 }
 
 void
 VICII::resetEmuTexture(int nr)
 {
-    assert(nr == 1 || nr == 2);
-    int *p = nr == 1 ? emuTexture1 : emuTexture2;
+    assert(nr >= 0 && nr < 3);
+    int *p = emuTextures[nr];
 
     // Determine the HBLANK / VBLANK area
     long width = isPAL() ? PAL_PIXELS : NTSC_PIXELS;
@@ -131,14 +159,34 @@ VICII::resetEmuTexture(int nr)
 void
 VICII::resetDmaTexture(int nr)
 {
-    assert(nr == 1 || nr == 2);
-    int *p = nr == 1 ? dmaTexture1 : dmaTexture2;
+    assert(nr >= 0 && nr < 3);
+    int *p = dmaTextures[nr];
 
     for (int i = 0; i < TEX_HEIGHT * TEX_WIDTH; i++) {
         p[i] = 0xFF000000;
     }
 }
 
+void
+VICII::resetEmuTextures()
+{
+    resetEmuTexture(workingBuffer);
+    resetEmuTexture(withdrawFinishedBuffer());
+}
+
+void
+VICII::resetDmaTextures()
+{
+    resetDmaTexture(workingBuffer);
+    resetDmaTexture(withdrawFinishedBuffer());
+}
+
+int
+VICII::withdrawFinishedBuffer()
+{
+    return finishedBuffer.fetch_and((u8)~FRESH_FRAME, std::memory_order_acq_rel) & 3;
+}
+
 long
 VICII::getConfigItem(ConfigOption option)
 {
@@ -168,6 +216,8 @@ VICII::getConfigItem(ConfigOption option)
         case OPT_CUT_OPACITY:      return config.cutOpacity;
         case OPT_SS_COLLISIONS:    return config.checkSSCollisions;
         case OPT_SB_COLLISIONS:    return config.checkSBCollisions;
+        case OPT_RENDER_INTERVAL:  return config.renderInterval;
+        case OPT_FRAMEBUFFER:      return config.framebuffer;
 
         default: assert(false);
     }
@@ -323,6 +373,27 @@ VICII::setConfigItem(ConfigOption option, long value)
             config.checkSBCollisions = value;
             return true;
 
+        case OPT_RENDER_INTERVAL:
+            
+            if (value < 1 || value > 0xFFFF) {
+                warn("Invalid render interval: %d\n", value);
+                return false;
+            }
+            
+            config.renderInterval = (u16)value;
+            return true;
+
+        case OPT_FRAMEBUFFER:
+            
+            if (!isFramebufferFormat(value)) {
+                warn("Invalid framebuffer format: %d\n", value);
+                return false;
+            }
+            
+            // Takes effect at the beginning of the next frame
+            config.framebuffer = (FramebufferFormat)value;
+            return true;
+
         case OPT_GLUE_LOGIC:
             
             if (!isGlueLogic(value)) {
@@ -645,19 +716,30 @@ VICII::isVBlankLine(unsigned rasterline)
 void *
 VICII::stableEmuTexture()
 {
-    return emuTexture == emuTexture1 ? emuTexture2 : emuTexture1;
-}
-
-void *
-VICII::stableDmaTexture()
-{
-    return dmaTexture == dmaTexture1 ? dmaTexture2 : dmaTexture1;
+    /* Trade the stable buffer for the finished one if it holds a new frame.
+     * The swap only succeeds while the FRESH_FRAME bit is set. Hence, a
+     * buffer that has been withdrawn for a reset is never picked up.
+     */
+    u8 expected = finishedBuffer.load(std::memory_order_relaxed);
+    while (expected & FRESH_FRAME) {
+        
+        if (finishedBuffer.compare_exchange_strong(expected, (u8)stableBuffer,
+                                                   std::memory_order_acq_rel,
+                                                   std::memory_order_relaxed)) {
+            stableBuffer = expected & 3;
+            
+            // Frames drawn in indexed mode are converted when they are picked up
+            if (unconverted[stableBuffer]) convertTexture(stableBuffer);
+            break;
+        }
+    }
+    return emuTextures[stableBuffer];
 }
 
 u32 *
 VICII::getNoise()
 {
-    int offset = rand() % (512 * 512);
+    int offset = xorshift32(noiseState) % (512 * 512);
     return noise + offset;
 }
 
@@ -1012,32 +1094,48 @@ VICII::beginFrame()
      *  and is irrelevant." [C.B.]
      */
     vcBase = 0;
+    
+    // Decide whether this frame is going to be drawn
+    skipFrame =
+    config.renderInterval > 1 &&
+    c64.inWarpMode() &&
+    !config.dmaDebug &&
+    c64.frame % config.renderInterval != 0;
+    
+    // Decide whether this frame is going to be converted to RGBA later
+    deferConversion =
+    config.framebuffer == FRAMEBUFFER_INDEXED &&
+    !config.dmaDebug &&
+    !(config.cutLayers & 0xF00);
 }
 
 void
 VICII::endFrame()
 {
+    // Keep the stable texture if this frame hasn't been drawn
+    if (skipFrame) {
+        emuTexturePtr = emuTexture;
+        idxTexturePtr = idxTexture;
+        return;
+    }
+    
     // Run the DMA debugger (if enabled)
     if (config.dmaDebug) {
         computeOverlay();
     }
 
-    // Switch texture buffers
-    if (emuTexture == emuTexture1) {
-        
-        assert(dmaTexture == dmaTexture1);
-        emuTexture = emuTexturePtr = emuTexture2;
-        dmaTexture = dmaTexturePtr = dmaTexture2;
-        if (config.dmaDebug) { resetEmuTexture(2); resetDmaTexture(2); }
-
-    } else {
-        
-        assert(emuTexture == emuTexture2);
-        assert(dmaTexture == dmaTexture2);
-        emuTexture = emuTexturePtr = emuTexture1;
-        dmaTexture = dmaTexturePtr = dmaTexture1;
-        if (config.dmaDebug) { resetEmuTexture(1); resetDmaTexture(1); }
-    }
+    // Hand the finished frame over and continue with the released buffer
+    frameNr[workingBuffer] = c64.frame;
+    unconverted[workingBuffer] = deferConversion;
+    lastBuffer = workingBuffer;
+    workingBuffer =
+    finishedBuffer.exchange((u8)(workingBuffer | FRESH_FRAME), std::memory_order_acq_rel) & 3;
+    
+    emuTexture = emuTexturePtr = emuTextures[workingBuffer];
+    dmaTexture = dmaTexturePtr = dmaTextures[workingBuffer];
+    idxTexture = idxTexturePtr = idxTextures[workingBuffer];
+    rowCount[workingBuffer] = 0;
+    if (config.dmaDebug) { resetEmuTexture(workingBuffer); resetDmaTexture(workingBuffer); }
 }
 
 void
@@ -1111,13 +1209,24 @@ VICII::endRasterline()
         setVerticalFrameFF(true);
     }
     
+    // Keep track of the rows that need to be converted to RGBA later
+    if (deferConversion && !skipFrame && !vblank) {
+        
+        u16 row = (u16)((idxTexturePtr - idxTexture) / TEX_WIDTH);
+        if (rowCount[workingBuffer] == 0) firstRow[workingBuffer] = row;
+        rowCount[workingBuffer] = row - firstRow[workingBuffer] + 1;
+    }
+    
     // Cut out layers if requested
-    if (config.cutLayers) cutLayers();
+    if (config.cutLayers && !skipFrame) cutLayers();
 
-    // Prepare buffers ready for the next line
-    for (unsigned i = 0; i < TEX_WIDTH; i++) { zBuffer[i] = pixelSource[i] = 0; }
+    // Prepare buffers ready for the next line (untouched in skipped frames)
+    if (!skipFrame) {
+        for (unsigned i = 0; i < TEX_WIDTH; i++) { zBuffer[i] = pixelSource[i] = 0; }
+    }
         
     // Advance texture pointers
     emuTexturePtr = emuTexture + (c64.rasterLine * TEX_WIDTH);
     dmaTexturePtr = dmaTexture + (c64.rasterLine * TEX_WIDTH);
+    idxTexturePtr = idxTexture + (c64.rasterLine * TEX_WIDTH);
 }
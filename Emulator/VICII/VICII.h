@@ -12,6 +12,9 @@
 
 #include "C64Component.h"
 #include "TimeDelayed.h"
+#include "PixelConverter.h"
+
+#include <atomic>
 
 class VICII : public C64Component {
 
@@ -477,33 +480,71 @@ private:
     // C64 colors in RGBA format (updated in updatePalette())
     u32 rgbaTable[16];
     
+    // Expands color indices with the current palette
+    PixelConverter converter;
+    
     // Buffer storing background noise (random black and white pixels)
     u32 *noise;
+    
+    // Random number generator state (used to pick a noise window)
+    u32 noiseState = 1;
 
     /* Texture buffers. VICII outputs the generated texture into these buffers.
-     * At any time, one buffer is the working buffer and the other one is the
-     * stable buffer. While VICII always writes into the working buffer, the
-     * GUI accesses the stable buffer at a constant frame rate and copies it
-     * into the texture RAM of the graphics card.
+     * The buffers form a triple buffer which hands finished frames over to a
+     * consumer running in another thread (usually the GUI). At any time, one
+     * buffer is owned by VICII (the working buffer), one buffer is owned by
+     * the consumer (the stable buffer), and the third buffer holds the most
+     * recently finished frame. At the end of a frame, VICII swaps the working
+     * buffer with the third buffer. When the consumer asks for a new frame,
+     * it swaps the stable buffer with the third buffer if the latter holds a
+     * frame it hasn't seen yet. Both swaps are single atomic operations. Thus,
+     * neither side ever blocks and the consumer never sees a buffer that is
+     * being written to. If the consumer is slower than the emulator, frames
+     * are dropped. The frame numbers tell the consumer how many.
      *
      * The emuTexture buffers contain the emulator texture. It is the texture
      * that is usually drawn by the GUI. The dmaTexture buffers contain the
      * texture generated by the DMA debugger. If DMA debugging is enabled, this
-     * texture is superimposed on the emulator texture.
-     */
-    int *emuTexture1 = new int[TEX_HEIGHT * TEX_WIDTH];
-    int *emuTexture2 = new int[TEX_HEIGHT * TEX_WIDTH];
-    int *dmaTexture1 = new int[TEX_HEIGHT * TEX_WIDTH];
-    int *dmaTexture2 = new int[TEX_HEIGHT * TEX_WIDTH];
-    /*
+     * texture is superimposed on the emulator texture. Both are handed over
+     * together.
+     *
+     * In RGBA mode (see FramebufferFormat), the pixel pipeline writes RGBA
+     * values into the emuTexture buffers directly. In indexed mode, it writes
+     * color indices into the idxTexture buffers instead. The conversion to
+     * RGBA is deferred until a frame is requested by a consumer. Frames that
+     * are never consumed are never converted.
      */
-     
-    /* Pointer to the current working texture. This variable points either to
-     * the first or the second texture buffer. After a frame has been finished,
-     * the pointer is redirected to the other buffer.
+    int *emuTextures[3];
+    int *dmaTextures[3];
+    u8 *idxTextures[3];
+    
+    // Number of the frame stored in each buffer
+    u64 frameNr[3] = { 0, 0, 0 };
+    
+    // Indicates which buffers still need to be converted to RGBA
+    bool unconverted[3] = { false, false, false };
+    
+    // Range of rows that have been drawn into each buffer
+    u16 firstRow[3] = { 0, 0, 0 };
+    u16 rowCount[3] = { 0, 0, 0 };
+    
+    // Buffer indices of the working buffer and the stable buffer
+    int workingBuffer = 0;
+    int stableBuffer = 1;
+    
+    /* Buffer index of the most recently finished frame. The FRESH_FRAME bit
+     * is set if the consumer hasn't picked up the frame yet.
      */
+    static const u8 FRESH_FRAME = 0x80;
+    std::atomic<u8> finishedBuffer { 2 };
+    
+    // Buffer index of the frame that has been finished last (emulator side)
+    int lastBuffer = 2;
+    
+    // Pointer to the current working texture
     int *emuTexture;
     int *dmaTexture;
+    u8 *idxTexture;
 
     /* Pointer to the beginning of the current rasterline inside the current
      * working textures. These pointers are used by all rendering methods to
@@ -513,6 +554,24 @@ private:
      */
     int *emuTexturePtr;
     int *dmaTexturePtr;
+    u8 *idxTexturePtr;
+
+    /* Indicates if the current frame is skipped. If a render interval greater
+     * than 1 is configured, only every n-th frame is drawn in warp mode. In
+     * all other frames, the pixel pipeline only runs as far as needed to keep
+     * the emulation exact (the graphics sequencer state and the collision
+     * information). No pixels are written and the texture buffers aren't
+     * switched at the end of the frame.
+     */
+    bool skipFrame = false;
+    
+    /* Indicates if the RGBA conversion of the current frame is deferred, i.e.,
+     * if color indices are drawn instead of RGBA values. The value is
+     * determined at the beginning of each frame. Conversion is never deferred
+     * if the DMA debugger or layer cutting is active, because both operate on
+     * RGBA values.
+     */
+    bool deferConversion = false;
 
     /* VICII utilizes a depth buffer to determine pixel priority. The render
      * routines only write a color value, if it is closer to the view point.
@@ -532,6 +591,15 @@ private:
      */
     u16 pixelSource[TEX_WIDTH];
     
+    /* Collision information of skipped frames. Instead of writing into the
+     * pixelSource array, the collision-only pipeline records the pixels of
+     * the current cycle that are covered by the foreground and by each
+     * sprite, one bit per pixel. The masks are consumed by the sprite drawing
+     * routine in the same cycle and are zero at the beginning of each cycle.
+     */
+    u8 foregroundMask = 0;
+    u8 spriteMask[8] = { };
+    
     /* Offset into to pixelBuffer. This variable points to the first pixel of
      * the currently drawn 8 pixel chunk.
      */
@@ -573,6 +641,7 @@ private:
 public:
 	
     VICII(C64 &ref);
+    ~VICII();
     
 private:
     
@@ -580,9 +649,16 @@ private:
     void _reset() override;
 
     void resetEmuTexture(int nr);
-    void resetEmuTextures() { resetEmuTexture(1); resetEmuTexture(2); }
     void resetDmaTexture(int nr);
-    void resetDmaTextures() { resetDmaTexture(1); resetDmaTexture(2); }
+
+    /* Resets the working buffer and the finished buffer. The stable buffer
+     * is left alone, because it belongs to the consumer (see
+     * stableEmuTexture()). The finished frame is withdrawn to keep the
+     * consumer from picking it up while it is reset.
+     */
+    void resetEmuTextures();
+    void resetDmaTextures();
+    int withdrawFinishedBuffer();
 
     
     //
@@ -789,9 +865,45 @@ public:
     // Accessing the screen buffer and display properties
     //
     
-    // Returns the currently stable textures
+    /* Returns the currently stable textures (consumer side). The emulator
+     * texture is advanced to the most recently finished frame. The returned
+     * buffers stay untouched until the next call to stableEmuTexture(). Only
+     * a single consumer thread must call this function.
+     */
     void *stableEmuTexture();
-    void *stableDmaTexture();
+    void *stableDmaTexture() { return dmaTextures[stableBuffer]; }
+    
+    /* Returns the color indices of the stable texture (consumer side). Unlike
+     * stableEmuTexture(), this function doesn't advance to a new frame.
+     */
+    u8 *stableIdxTexture() { return idxTextures[stableBuffer]; }
+    
+    // Returns the frame number of the stable textures (consumer side)
+    u64 stableFrameNr() { return frameNr[stableBuffer]; }
+    
+    // Checks if a frame has been finished that the consumer hasn't seen yet
+    bool hasFreshFrame() { return finishedBuffer.load() & FRESH_FRAME; }
+    
+    /* Returns the texture of the last finished frame (emulator side). Other
+     * than stableEmuTexture(), this function doesn't affect the consumer.
+     * It must only be called from the emulator thread or while the emulator
+     * is suspended.
+     */
+    void *finishedEmuTexture() { return emuTextures[lastBuffer]; }
+    u64 finishedFrameNr() { return frameNr[lastBuffer]; }
+    
+    /* Converts the last finished frame (emulator side) or the stable frame
+     * (consumer side) into the requested pixel format. If 'crop' is true,
+     * only the visible area is converted. Otherwise, the whole texture is
+     * converted.
+     */
+    void convertFinishedFrame(void *dst, PixelFormat format, bool crop = true) {
+        convertFrame(lastBuffer, dst, format, crop); }
+    void convertStableFrame(void *dst, PixelFormat format, bool crop = true) {
+        convertFrame(stableBuffer, dst, format, crop); }
+    
+    // Converts color indices into RGBA values with the current palette
+    void indexToRgba(const u8 *src, u32 *dst, size_t count);
     
     // Returns a pointer to randon noise
     u32 *getNoise();
@@ -1213,13 +1325,22 @@ public:
     void cycle64ntsc();
     void cycle65ntsc();
 	
-    #define DRAW_SPRITES if (spriteDisplay || isSecondDMAcycle) drawSprites();
-    #define DRAW_SPRITES59 if (spriteDisplayDelayed || spriteDisplay || isSecondDMAcycle) drawSprites();
-
-    #define DRAW if (!vblank) draw(); DRAW_SPRITES;
-    #define DRAW17 if (!vblank) draw17(); DRAW_SPRITES;
-    #define DRAW55 if (!vblank) draw55(); DRAW_SPRITES;
-    #define DRAW59 if (!vblank) draw(); DRAW_SPRITES59;
+    #define SPRITES_DRAWN (spriteDisplay || isSecondDMAcycle)
+    #define SPRITES_DRAWN59 (spriteDisplayDelayed || spriteDisplay || isSecondDMAcycle)
+    #define SPRITES(x) if (x) { if (skipFrame) drawSprites<false>(); else drawSprites<true>(); }
+    #define DRAW_SPRITES SPRITES(SPRITES_DRAWN)
+    #define DRAW_SPRITES59 SPRITES(SPRITES_DRAWN59)
+
+    /* In skipped frames, the foreground mask is only needed if sprites are
+     * drawn in the same cycle, because it is checked for collisions.
+     */
+    #define CANVAS(x,draw,mask) \
+    if (!vblank) { if (!skipFrame) draw(); else if (x) mask(); else skipCanvas(); }
+    
+    #define DRAW CANVAS(SPRITES_DRAWN, draw, maskCanvas) DRAW_SPRITES;
+    #define DRAW17 CANVAS(SPRITES_DRAWN, draw17, maskCanvas17) DRAW_SPRITES;
+    #define DRAW55 CANVAS(SPRITES_DRAWN, draw55, maskCanvas55) DRAW_SPRITES;
+    #define DRAW59 CANVAS(SPRITES_DRAWN59, draw, maskCanvas) DRAW_SPRITES59;
     #define DRAW_IDLE DRAW_SPRITES;
         
     #define END_CYCLE \
@@ -1251,6 +1372,20 @@ private:
     
     // Special draw routine for cycle 55
     void draw55();
+    
+    /* Advances the graphics sequencer by 8 pixels without drawing anything.
+     * This function replaces draw() in skipped frames if no sprite pixels
+     * need to be checked for collisions.
+     */
+    void skipCanvas();
+    
+    /* Collision-only counterparts of draw(), draw17(), and draw55(). They
+     * advance the graphics sequencer and compute the foreground mask of the
+     * 8 pixels that are not covered by the border.
+     */
+    void maskCanvas();
+    void maskCanvas17();
+    void maskCanvas55();
         
     
     //
@@ -1266,8 +1401,17 @@ private:
     // Draws the border pixels in cycle 55 (see draw55())
     void drawBorder55();
     
-    // Draws 8 canvas pixels (see draw())
-    void drawCanvas();
+    /* Draws 8 canvas pixels (see draw()). If 'pixels' is false, only the
+     * state of the graphics sequencer and the foreground mask are updated.
+     */
+    template <bool pixels> void drawCanvas();
+    
+    /* Draws 8 canvas pixels at once. This function is called by drawCanvas()
+     * if none of the registers affecting the canvas changes during the cycle.
+     * In this case, the display mode and the background colors are the same
+     * for all pixels.
+     */
+    template <bool pixels> void drawCanvasFast();
     
     /* Draws a single canvas pixel
      *
@@ -1277,14 +1421,29 @@ private:
      *  loadShiftReg : forces the shift register to be reloaded
      *  updateColors : forces the four selectable colors to be reloaded
      */
-    void drawCanvasPixel(u8 pixel,
-                         u8 mode,
-                         u8 d016,
-                         bool loadShiftReg,
-                         bool updateColors);
+    template <bool pixels> void drawCanvasPixel(u8 pixel,
+                                                u8 mode,
+                                                u8 d016,
+                                                bool loadShiftReg,
+                                                bool updateColors);
+    
+    /* Draws 8 sprite pixels (see draw()). If 'pixels' is false, only the
+     * sprite masks are computed and checked for collisions.
+     */
+    template <bool pixels> void drawSprites();
     
-    // Draws 8 sprite pixels (see draw())
-    void drawSprites();
+    /* Draws 8 sprite pixels at once. This function is called by drawSprites()
+     * if no sprite DMA takes place and none of the sprite registers changes
+     * during the cycle. In this case, the sprites can be processed one after
+     * another instead of pixel by pixel.
+     */
+    template <bool pixels> void drawSpritesFast();
+    
+    /* Runs the shift register of a single sprite for 8 pixels. The function
+     * returns the color bits of all pixels that are drawn, one byte per pixel
+     * with the first pixel in the lowest byte.
+     */
+    u64 runSpriteShiftRegister(unsigned sprite, bool enable);
     
     /* Draws a single sprite pixel for all sprites
      *
@@ -1292,9 +1451,15 @@ private:
      *    enableBits : the spriteDisplay bits
      *    freezeBits : forces the sprites shift register to freeze temporarily
      */
-    void drawSpritePixel(unsigned pixel,
-                         u8 enableBits,
-                         u8 freezeBits);
+    template <bool pixels> void drawSpritePixel(unsigned pixel,
+                                                u8 enableBits,
+                                                u8 freezeBits);
+    
+    /* Checks the foreground mask and the sprite masks for collisions. This
+     * is the collision-only counterpart of the pixelSource check performed
+     * at the end of drawSprites(). drawSpritesFast() uses it in both modes.
+     */
+    void checkCollisions();
     
     
     //
@@ -1309,10 +1474,24 @@ private:
     // Low level drawing (pixel buffer access)
     //
     
-    // Writes a single color value into the screenbuffer
+    /* Writes a single color value into the screenbuffer. The color index is
+     * stored if the RGBA conversion is deferred. Otherwise, the RGBA value is
+     * written directly.
+     */
     #define COLORIZE(index,color) \
         assert(index < TEX_WIDTH); \
-        emuTexturePtr[index] = rgbaTable[color];
+        if (deferConversion) idxTexturePtr[index] = color; \
+        else emuTexturePtr[index] = rgbaTable[color];
+    
+    // Converts the drawn part of a texture buffer to RGBA
+    void convertTexture(int nr);
+    
+    /* Converts a texture buffer into the requested pixel format. Drawn rows
+     * that haven't been converted to RGBA yet are taken from the color
+     * indices. Everything else is taken from the RGBA texture, which also
+     * contains the DMA debugger overlay and cut out layers.
+     */
+    void convertFrame(int nr, void *dst, PixelFormat format, bool crop);
     
     /* Sets a single frame pixel. The upper bit in pixelSource is cleared to
      * prevent sprite/foreground collision detection in border area.
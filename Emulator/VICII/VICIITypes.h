@@ -89,6 +89,42 @@ inline bool isPalette(long value) {
     return value >= COLOR_PALETTE && value <= SEPIA_PALETTE;
 }
 
+typedef enum : long
+{
+    FRAMEBUFFER_RGBA = 0,
+    FRAMEBUFFER_INDEXED = 1
+}
+FramebufferFormat;
+
+inline bool isFramebufferFormat(long value) {
+    return value == FRAMEBUFFER_RGBA || value == FRAMEBUFFER_INDEXED;
+}
+
+typedef enum : long
+{
+    PIXEL_RGBA = 0,     // 32 bit, red in the lowest byte (texture format)
+    PIXEL_BGRA = 1,     // 32 bit, blue in the lowest byte
+    PIXEL_RGB565 = 2    // 16 bit, red in the upper five bits
+}
+PixelFormat;
+
+inline bool isPixelFormat(long value) {
+    return value >= PIXEL_RGBA && value <= PIXEL_RGB565;
+}
+
+typedef enum : long
+{
+    PIXEL_KERNEL_SCALAR = 0,
+    PIXEL_KERNEL_SSSE3 = 1,
+    PIXEL_KERNEL_AVX2 = 2,
+    PIXEL_KERNEL_NEON = 3
+}
+PixelKernel;
+
+inline bool isPixelKernel(long value) {
+    return value >= PIXEL_KERNEL_SCALAR && value <= PIXEL_KERNEL_NEON;
+}
+
 typedef enum
 {
     COL_40_ROW_25 = 0x01,
@@ -159,6 +195,10 @@ typedef struct
     // Cheating
     bool checkSSCollisions;
     bool checkSBCollisions;
+
+    // Performance
+    u16 renderInterval;
+    FramebufferFormat framebuffer;
 }
 VICConfig;
 
@@ -33,6 +33,12 @@ VICII::getColor(unsigned nr)
     return rgbaTable[nr];
 }
 
+void
+VICII::indexToRgba(const u8 *src, u32 *dst, size_t count)
+{
+    converter.convert(src, dst, count, PIXEL_RGBA);
+}
+
 u32
 VICII::getColor(unsigned nr, Palette palette)
 {
@@ -442,6 +448,7 @@ VICII::updatePalette()
     for (unsigned i = 0; i < 16; i++) {
         rgbaTable[i] = getColor(i, config.palette);
     }
+    converter.setPalette(rgbaTable);
 }
 
 
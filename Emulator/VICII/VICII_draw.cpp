@@ -9,27 +9,102 @@
 
 #include "C64.h"
 
+// Replicates a byte eight times
+#define BCAST8(x) ((u64)(x) * 0x0101010101010101ULL)
+
+/* Lookup tables of the fast canvas path. Both tables map a byte of the shift
+ * register to the color bits of eight consecutive pixels, one byte per pixel
+ * with the first pixel in the lowest byte.
+ */
+static struct CanvasTables {
+    
+    u64 singleColor[256];
+    u64 multiColor[256];
+    
+    CanvasTables() {
+        
+        for (unsigned data = 0; data < 256; data++) {
+            
+            singleColor[data] = multiColor[data] = 0;
+            for (unsigned i = 0; i < 8; i++) {
+                singleColor[data] |= (u64)((data >> (7 - i)) & 1) << (8 * i);
+                multiColor[data] |= (u64)((data >> (6 - (i & 6))) & 3) << (8 * i);
+            }
+        }
+    }
+} canvasTables;
+
+// Translates eight color bit pairs into eight colors
+static inline u64
+selectColors(u64 bits, const u8 *col)
+{
+    u64 lo = (bits & BCAST8(1)) * 0xFF;
+    u64 hi = ((bits >> 1) & BCAST8(1)) * 0xFF;
+    
+    return
+    (BCAST8(col[0]) & ~hi & ~lo) | (BCAST8(col[1]) & ~hi & lo) |
+    (BCAST8(col[2]) & hi & ~lo) | (BCAST8(col[3]) & hi & lo);
+}
+
 void
 VICII::draw()
 {
-    drawCanvas();
+    drawCanvas<true>();
     drawBorder();
 }
 
 void
 VICII::draw17()
 {
-    drawCanvas();
+    drawCanvas<true>();
     drawBorder17();
 }
 
 void
 VICII::draw55()
 {
-    drawCanvas();
+    drawCanvas<true>();
     drawBorder55();
 }
 
+void
+VICII::skipCanvas()
+{
+    drawCanvas<false>();
+    foregroundMask = 0;
+}
+
+void
+VICII::maskCanvas()
+{
+    drawCanvas<false>();
+    
+    // Border pixels don't collide with sprites (see drawBorder())
+    if (flipflops.delayed.main) foregroundMask = 0;
+}
+
+void
+VICII::maskCanvas17()
+{
+    drawCanvas<false>();
+    
+    // See drawBorder17()
+    if (flipflops.delayed.main) foregroundMask &= flipflops.current.main ? 0x00 : 0x80;
+}
+
+void
+VICII::maskCanvas55()
+{
+    drawCanvas<false>();
+    
+    // See drawBorder55()
+    if (flipflops.delayed.main) {
+        foregroundMask = 0;
+    } else if (flipflops.current.main) {
+        foregroundMask &= 0x7F;
+    }
+}
+
 void
 VICII::drawBorder()
 {
@@ -75,7 +150,7 @@ VICII::drawBorder55()
     }
 }
 
-void
+template <bool pixels> void
 VICII::drawCanvas()
 {
     u8 d011, d016, newD016, mode, oldMode, xscroll;
@@ -91,6 +166,7 @@ VICII::drawCanvas()
          *  current background color is displayed (this area is normally covered
          *  by the border)." [C.B.]
          */
+        if (!pixels) return;
         SET_BACKGROUND_PIXEL(0, col[0]);
         for (unsigned pixel = 1; pixel < 8; pixel++) {
             SET_BACKGROUND_PIXEL(pixel, col[0]);
@@ -104,12 +180,21 @@ VICII::drawCanvas()
      *  $d016." [C.B.]
      */
     
+    // Draw all pixels at once if no register changes show up in this cycle
+    if (memcmp(reg.delayed.colors + COLREG_BG0, reg.current.colors + COLREG_BG0, 4) == 0 &&
+        ((reg.delayed.ctrl2 ^ reg.current.ctrl2) & 0x10) == 0 &&
+        (((reg.delayed.ctrl1 ^ reg.current.ctrl1) & 0x60) == 0 || !is656x())) {
+        
+        drawCanvasFast<pixels>();
+        return;
+    }
+    
     d011 = reg.delayed.ctrl1;
     d016 = reg.delayed.ctrl2;
     xscroll = d016 & 0x07;
     mode = (d011 & 0x60) | (d016 & 0x10); // -xxx ----
 
-    drawCanvasPixel(0, mode, d016, xscroll == 0, true);
+    drawCanvasPixel<pixels>(0, mode, d016, xscroll == 0, true);
     
     // After the first pixel, color register changes show up
     reg.delayed.colors[COLREG_BG0] = reg.current.colors[COLREG_BG0];
@@ -117,9 +202,9 @@ VICII::drawCanvas()
     reg.delayed.colors[COLREG_BG2] = reg.current.colors[COLREG_BG2];
     reg.delayed.colors[COLREG_BG3] = reg.current.colors[COLREG_BG3];
 
-    drawCanvasPixel(1, mode, d016, xscroll == 1, true);
-    drawCanvasPixel(2, mode, d016, xscroll == 2, false);
-    drawCanvasPixel(3, mode, d016, xscroll == 3, false);
+    drawCanvasPixel<pixels>(1, mode, d016, xscroll == 1, true);
+    drawCanvasPixel<pixels>(2, mode, d016, xscroll == 2, false);
+    drawCanvasPixel<pixels>(3, mode, d016, xscroll == 3, false);
 
     // After pixel 4, a change in D016 affects the display mode.
     newD016 = reg.current.ctrl2;
@@ -131,8 +216,8 @@ VICII::drawCanvas()
     oldMode = mode;
     mode = (d011 & 0x60) | (newD016 & 0x10);
     
-    drawCanvasPixel(4, mode, d016, xscroll == 4, oldMode != mode);
-    drawCanvasPixel(5, mode, d016, xscroll == 5, false);
+    drawCanvasPixel<pixels>(4, mode, d016, xscroll == 4, oldMode != mode);
+    drawCanvasPixel<pixels>(5, mode, d016, xscroll == 5, false);
     
     // In older VICIIs, the zero bits of D011 show up here.
     if (is656x()) {
@@ -141,7 +226,7 @@ VICII::drawCanvas()
         mode = (d011 & 0x60) | (newD016 & 0x10);
     }
 
-    drawCanvasPixel(6, mode, d016, xscroll == 6, oldMode != mode);
+    drawCanvasPixel<pixels>(6, mode, d016, xscroll == 6, oldMode != mode);
     
     // Before the last pixel is drawn, a change is D016 is fully detected.
     // If the multicolor bit get set, the mc flip flop is also reset.
@@ -151,11 +236,118 @@ VICII::drawCanvas()
         d016 = newD016;
     }
  
-    drawCanvasPixel(7, mode, d016, xscroll == 7, false);
+    drawCanvasPixel<pixels>(7, mode, d016, xscroll == 7, false);
 }
 
+template <bool pixels> void
+VICII::drawCanvasFast()
+{
+    u8 mode = (reg.delayed.ctrl1 & 0x60) | (reg.delayed.ctrl2 & 0x10);
+    u8 xscroll = reg.delayed.ctrl2 & 0x07;
+    
+    // First pixel that is synthesized from a freshly loaded shift register
+    unsigned load = sr.canLoad ? xscroll : 8;
+    u64 segment = load < 8 ? (1ULL << (8 * load)) - 1 : ~0ULL;
+    
+    u64 colors = 0, foreground = 0;
+    
+    // Pixels in front of the load are synthesized from the old register value
+    if (load > 0) {
+        
+        u64 bits = 0;
+        bool multicolor = (mode & 0x10) && ((mode & 0x20) || (sr.latchedColor & 0x8));
+        
+        if (multicolor) {
+            
+            // Multicolor bits are only picked up every other pixel
+            for (unsigned i = 0; i < load; i++) {
+                
+                if (!sr.remainingBits) sr.colorbits = 0;
+                if (sr.mcFlop) sr.colorbits = sr.data >> 6;
+                bits |= (u64)sr.colorbits << (8 * i);
+                
+                sr.data <<= 1;
+                sr.mcFlop = !sr.mcFlop;
+                sr.remainingBits -= 1;
+            }
+            foreground = ((bits >> 1) & BCAST8(1)) * 0xFF;
+            
+        } else {
+            
+            bits = canvasTables.singleColor[sr.data];
+            sr.colorbits = (u8)(sr.data << (load - 1)) >> 7;
+            sr.data = (u8)(sr.data << load);
+            sr.mcFlop ^= load & 1;
+            sr.remainingBits -= load;
+            foreground = (bits & BCAST8(1)) * 0xFF;
+        }
+        
+        loadColors(mode);
+        colors = selectColors(bits, col) & segment;
+        foreground &= segment;
+    }
+    
+    // Pixels starting at the load are synthesized from the new register value
+    if (load < 8) {
+        
+        u32 result = gAccessResult.delayed();
+        unsigned count = 8 - load;
+        
+        sr.data = BYTE0(result);
+        sr.latchedCharacter = BYTE2(result);
+        sr.latchedColor = BYTE1(result);
+        
+        u64 bits;
+        bool multicolor = (mode & 0x10) && ((mode & 0x20) || (sr.latchedColor & 0x8));
+        
+        if (multicolor) {
+            bits = canvasTables.multiColor[sr.data] << (8 * load);
+            foreground |= ((bits >> 1) & BCAST8(1)) * 0xFF;
+        } else {
+            bits = canvasTables.singleColor[sr.data] << (8 * load);
+            foreground |= (bits & BCAST8(1)) * 0xFF;
+        }
+        
+        sr.colorbits = (u8)(bits >> 56);
+        sr.data = (u8)(sr.data << count);
+        sr.mcFlop = !(count & 1);
+        sr.remainingBits = 8 - count;
+        
+        loadColors(mode);
+        colors |= selectColors(bits, col) & ~segment;
+    }
+    assert(sr.colorbits < 4);
+    
+    if (!pixels) {
+        
+        // Only record the foreground pixels
+        foregroundMask |= (u8)(((foreground & BCAST8(1)) * 0x0102040810204080ULL) >> 56);
+        
+    } else {
+        
+        // Write the pixels (the first pixel is stored in the lowest byte)
+        int index = bufferoffset;
+        assert(index + 7 < TEX_WIDTH);
+        
+        u64 depth =
+        (BCAST8(FOREGROUND_LAYER_DEPTH) & foreground) |
+        (BCAST8(BACKGROUD_LAYER_DEPTH) & ~foreground);
+        
+        if (deferConversion) {
+            memcpy(idxTexturePtr + index, &colors, 8);
+        } else {
+            for (unsigned i = 0; i < 8; i++) {
+                emuTexturePtr[index + i] = rgbaTable[(colors >> (8 * i)) & 0xF];
+            }
+        }
+        memcpy(zBuffer + index, &depth, 8);
+        for (unsigned i = 0; i < 8; i++) {
+            pixelSource[index + i] = (u16)((foreground >> (8 * i)) & 1) << 8;
+        }
+    }
+}
 
-void
+template <bool pixels> void
 VICII::drawCanvasPixel(u8 pixel,
                        u8 mode,
                        u8 d016,
@@ -217,22 +409,32 @@ VICII::drawCanvasPixel(u8 pixel,
     
     // Draw pixel
     assert(sr.colorbits < 4);
-    if (multicolorDisplayMode) {
+    if (!pixels) {
         
-        // Set multi-color pixel
-        if (sr.colorbits & 0x02) {
-            SET_FOREGROUND_PIXEL(pixel, col[sr.colorbits]);
-        } else {
-            SET_BACKGROUND_PIXEL(pixel, col[sr.colorbits]);
+        // Only record if this is a foreground pixel
+        if (multicolorDisplayMode ? (sr.colorbits & 0x02) : sr.colorbits) {
+            foregroundMask |= 1 << pixel;
         }
         
     } else {
+
+        if (multicolorDisplayMode) {
+        
+            // Set multi-color pixel
+            if (sr.colorbits & 0x02) {
+                SET_FOREGROUND_PIXEL(pixel, col[sr.colorbits]);
+            } else {
+                SET_BACKGROUND_PIXEL(pixel, col[sr.colorbits]);
+            }
         
-        // Set single-color pixel
-        if (sr.colorbits) {
-            SET_FOREGROUND_PIXEL(pixel, col[sr.colorbits]);
         } else {
-            SET_BACKGROUND_PIXEL(pixel, col[sr.colorbits]);
+        
+            // Set single-color pixel
+            if (sr.colorbits) {
+                SET_FOREGROUND_PIXEL(pixel, col[sr.colorbits]);
+            } else {
+                SET_BACKGROUND_PIXEL(pixel, col[sr.colorbits]);
+            }
         }
     }
     
@@ -242,14 +444,26 @@ VICII::drawCanvasPixel(u8 pixel,
     sr.remainingBits -= 1;
 }
 
-void
+template <bool pixels> void
 VICII::drawSprites()
 {
     u8 firstDMA = isFirstDMAcycle;
     u8 secondDMA = isSecondDMAcycle;
     
+    // Draw all pixels at once if no register changes show up in this cycle
+    if (!(firstDMA | secondDMA) &&
+        spriteDisplay == spriteDisplayDelayed &&
+        reg.delayed.sprExpandX == reg.current.sprExpandX &&
+        reg.delayed.sprPriority == reg.current.sprPriority &&
+        reg.delayed.sprMC == reg.current.sprMC &&
+        memcmp(reg.delayed.colors + COLREG_SPR_EX1, reg.current.colors + COLREG_SPR_EX1, 10) == 0) {
+        
+        drawSpritesFast<pixels>();
+        return;
+    }
+    
     // Pixel 0
-    drawSpritePixel(0, spriteDisplayDelayed, secondDMA);
+    drawSpritePixel<pixels>(0, spriteDisplayDelayed, secondDMA);
     
     // After the first pixel, color register changes show up
     reg.delayed.colors[COLREG_SPR_EX1] = reg.current.colors[COLREG_SPR_EX1];
@@ -259,20 +473,20 @@ VICII::drawSprites()
     }
     
     // Pixel 1, Pixel 2, Pixel 3
-    drawSpritePixel(1, spriteDisplayDelayed, secondDMA);
+    drawSpritePixel<pixels>(1, spriteDisplayDelayed, secondDMA);
     
     // Stop shift register on the second DMA cycle
     spriteSrActive &= ~secondDMA;
     
-    drawSpritePixel(2, spriteDisplayDelayed, secondDMA);
-    drawSpritePixel(3, spriteDisplayDelayed, firstDMA | secondDMA);
+    drawSpritePixel<pixels>(2, spriteDisplayDelayed, secondDMA);
+    drawSpritePixel<pixels>(3, spriteDisplayDelayed, firstDMA | secondDMA);
     
     // If a shift register is loaded, the new data appears here.
     updateSpriteShiftRegisters();
 
     // Pixel 4, Pixel 5
-    drawSpritePixel(4, spriteDisplay, firstDMA | secondDMA);
-    drawSpritePixel(5, spriteDisplay, firstDMA | secondDMA);
+    drawSpritePixel<pixels>(4, spriteDisplay, firstDMA | secondDMA);
+    drawSpritePixel<pixels>(5, spriteDisplay, firstDMA | secondDMA);
     
     // Changes of the X expansion bits and the priority bits show up here
     reg.delayed.sprExpandX = reg.current.sprExpandX;
@@ -296,7 +510,7 @@ VICII::drawSprites()
     }
     
     // Pixel 6
-    drawSpritePixel(6, spriteDisplay, firstDMA | secondDMA);
+    drawSpritePixel<pixels>(6, spriteDisplay, firstDMA | secondDMA);
     
     // Update multicolor bits if an old VICII is emulated
     if (toggle && is656x()) {
@@ -309,9 +523,13 @@ VICII::drawSprites()
     }
     
     // Pixel 7
-    drawSpritePixel(7, spriteDisplay, firstDMA);
+    drawSpritePixel<pixels>(7, spriteDisplay, firstDMA);
     
     // Check for collisions
+    if (!pixels) {
+        checkCollisions();
+        return;
+    }
     for (unsigned i = 0; i < 8; i++) {
         
         int index = bufferoffset + i;
@@ -342,7 +560,152 @@ VICII::drawSprites()
     }
 }
 
+template <bool pixels> void
+VICII::drawSpritesFast()
+{
+    u8 candidates = spriteDisplay | spriteSrActive;
+    u8 covered = 0;
+    
+    for (unsigned sprite = 0; sprite < 8; sprite++) {
+        
+        if (!GET_BIT(candidates, sprite)) continue;
+        
+        u64 bits = runSpriteShiftRegister(sprite, GET_BIT(spriteDisplay, sprite));
+        if (!bits || config.hideSprites) continue;
+        
+        // Determine the pixels that are covered by this sprite
+        u8 mask = 0;
+        for (unsigned pixel = 0; pixel < 8; pixel++) {
+            if ((bits >> (8 * pixel)) & 0x03) mask |= 1 << pixel;
+        }
+        covered |= mask;
+        spriteMask[sprite] |= mask;
+        if (!pixels) continue;
+        
+        u8 colors[4] = {
+            0,
+            reg.delayed.colors[COLREG_SPR_EX1],
+            reg.delayed.colors[COLREG_SPR0 + sprite],
+            reg.delayed.colors[COLREG_SPR_EX2]
+        };
+        for (unsigned pixel = 0; pixel < 8; pixel++) {
+            if (GET_BIT(mask, pixel)) {
+                setSpritePixel(sprite, pixel, colors[(bits >> (8 * pixel)) & 0x03]);
+            }
+        }
+    }
+    
+    // Check for collisions
+    if (!pixels) {
+        checkCollisions();
+        return;
+    }
+    if (covered) {
+        
+        // Collect the foreground pixels and run the collision-only check
+        for (unsigned pixel = 0; pixel < 8; pixel++) {
+            if (pixelSource[bufferoffset + pixel] & 0x100) foregroundMask |= 1 << pixel;
+        }
+        checkCollisions();
+    }
+}
+
+u64
+VICII::runSpriteShiftRegister(unsigned sprite, bool enable)
+{
+    SpriteSR &sr = spriteSr[sprite];
+    bool mCol = GET_BIT(reg.delayed.sprMC, sprite);
+    bool xExp = GET_BIT(reg.delayed.sprExpandX, sprite);
+    bool active = GET_BIT(spriteSrActive, sprite);
+    u64 bits = 0;
+    
+    // Nothing happens if the sprite is idle and not triggered in this cycle
+    if (!active && (!enable || (unsigned)(reg.delayed.sprX[sprite] - xCounter) >= 8)) {
+        return 0;
+    }
+    
+    // This is drawSpritePixel() for a single sprite without freeze bits
+    for (unsigned pixel = 0; pixel < 8; pixel++) {
+        
+        if (enable && !active && xCounter + pixel == reg.delayed.sprX[sprite]) {
+            
+            active = true;
+            sr.expFlop = true;
+            sr.mcFlop = true;
+        }
+        
+        if (active) {
+            
+            if (sr.expFlop) {
+                
+                if (mCol) {
+                    if (sr.mcFlop) sr.colBits = (sr.data >> 22) & 0x03;
+                    sr.mcFlop = !sr.mcFlop;
+                } else {
+                    sr.colBits = (sr.data >> 22) & 0x02;
+                }
+                
+                sr.data <<= 1;
+                if (!sr.data && !sr.colBits) active = false;
+            }
+            sr.expFlop = !sr.expFlop || !xExp;
+        }
+        
+        if (active) bits |= (u64)sr.colBits << (8 * pixel);
+    }
+    
+    WRITE_BIT(spriteSrActive, sprite, active);
+    return bits;
+}
+
 void
+VICII::checkCollisions()
+{
+    u8 covered = 0, multiple = 0;
+    
+    // Determine the pixels that are covered by more than one sprite
+    for (unsigned i = 0; i < 8; i++) {
+        multiple |= covered & spriteMask[i];
+        covered |= spriteMask[i];
+    }
+    
+    if (multiple || (covered & foregroundMask)) {
+        
+        u8 ss = 0, sb = 0;
+        
+        // Collect all sprites that are involved in a collision
+        for (unsigned i = 0; i < 8; i++) {
+            if (spriteMask[i] & multiple) ss |= 1 << i;
+            if (spriteMask[i] & foregroundMask) sb |= 1 << i;
+        }
+        
+        // Is it a sprite/sprite collision?
+        if (ss) {
+            
+            // Trigger an IRQ if this is the first detected collision
+            if (!spriteSpriteCollision) {
+                triggerIrq(4);
+            }
+            spriteSpriteCollision |= ss;
+        }
+        
+        // Is it a sprite/background collision?
+        if (sb && config.checkSBCollisions) {
+            
+            // Trigger an IRQ if this is the first detected collision
+            if (!spriteBackgroundColllision) {
+                triggerIrq(2);
+            }
+            spriteBackgroundColllision |= sb;
+        }
+    }
+    
+    // Prepare the masks for the next cycle
+    foregroundMask = 0;
+    memset(spriteMask, 0, sizeof(spriteMask));
+}
+
+template <bool pixels> void
 VICII::drawSpritePixel(unsigned pixel,
                      u8 enableBits,
                      u8 freezeBits)
@@ -409,7 +772,12 @@ VICII::drawSpritePixel(unsigned pixel,
         }
         
         // Draw pixel
-        if (active && !config.hideSprites) {
+        if (active && !config.hideSprites && !pixels) {
+            
+            // Only record if the pixel is set
+            if (spriteSr[sprite].colBits) spriteMask[sprite] |= 1 << pixel;
+            
+        } else if (active && !config.hideSprites) {
             
             switch (spriteSr[sprite].colBits) {
                     
@@ -524,10 +892,59 @@ VICII::setSpritePixel(unsigned sprite, unsigned pixel, u8 color)
     pixelSource[index] |= source;
 }
 
+void
+VICII::convertTexture(int nr)
+{
+    for (unsigned row = firstRow[nr]; row < firstRow[nr] + rowCount[nr]; row++) {
+        
+        size_t offset = row * TEX_WIDTH + FIRST_VISIBLE_PIXEL;
+        indexToRgba(idxTextures[nr] + offset,
+                    (u32 *)emuTextures[nr] + offset,
+                    VISIBLE_PIXELS);
+    }
+}
+
+void
+VICII::convertFrame(int nr, void *dst, PixelFormat format, bool crop)
+{
+    assert(nr >= 0 && nr < 3);
+    
+    long x1 = crop ? FIRST_VISIBLE_PIXEL : 0;
+    long x2 = crop ? FIRST_VISIBLE_PIXEL + VISIBLE_PIXELS : TEX_WIDTH;
+    long y1 = crop ? FIRST_VISIBLE_LINE : 0;
+    long y2 = crop ? FIRST_VISIBLE_LINE + numVisibleRasterlines() : TEX_HEIGHT;
+    
+    // Rows only available as color indices
+    long first = unconverted[nr] ? firstRow[nr] : 0;
+    long last = unconverted[nr] ? firstRow[nr] + rowCount[nr] : 0;
+    
+    size_t bpp = PixelConverter::bytesPerPixel(format);
+    u8 *target = (u8 *)dst;
+    
+    for (long y = y1; y < y2; y++, target += (x2 - x1) * bpp) {
+        
+        const u32 *rgba = (u32 *)emuTextures[nr] + y * TEX_WIDTH;
+        
+        if (y < first || y >= last) {
+            PixelConverter::convert(rgba + x1, target, x2 - x1, format);
+            continue;
+        }
+        
+        // Only the visible part of a row is drawn as color indices
+        const u8 *idx = idxTextures[nr] + y * TEX_WIDTH;
+        long v1 = FIRST_VISIBLE_PIXEL;
+        long v2 = FIRST_VISIBLE_PIXEL + VISIBLE_PIXELS;
+        
+        PixelConverter::convert(rgba + x1, target, v1 - x1, format);
+        converter.convert(idx + v1, target + (v1 - x1) * bpp, v2 - v1, format);
+        PixelConverter::convert(rgba + v2, target + (v2 - x1) * bpp, x2 - v2, format);
+    }
+}
+
 void
 VICII::cutLayers()
 {
-    for (int i = 0; i < TEX_WIDTH; i++) {
+    for (int i = FIRST_VISIBLE_PIXEL; i < FIRST_VISIBLE_PIXEL + VISIBLE_PIXELS; i++) {
         
         bool cut;
 
@@ -567,3 +984,6 @@ VICII::cutLayers()
         }
     }
 }
+
+template void VICII::drawSprites<true>();
+template void VICII::drawSprites<false>();
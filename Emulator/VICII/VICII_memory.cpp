@@ -624,6 +624,8 @@ VICII::memAccess(u16 addr)
     assert((bankAddr & 0x3FFF) == 0); // multiple of 16 KB
     
     addrBus = bankAddr | addr;
+    mem.countAccess(HEAT_VIC, addrBus, memSrc[addrBus >> 12]);
+    
     switch (memSrc[addrBus >> 12]) {
             
         case M_RAM:
@@ -256,6 +256,8 @@ struct AnyC64FileWrapper;
 - (void) disable:(NSInteger)nr;
 - (void) remove:(NSInteger)nr;
 - (void) replace:(NSInteger)nr addr:(NSInteger)addr;
+- (void) setAccess:(NSInteger)nr access:(WatchAccess)access;
+- (void) setCondition:(NSInteger)nr mask:(NSInteger)mask value:(NSInteger)value;
 
 - (BOOL) isSetAt:(NSInteger)addr;
 - (BOOL) isSetAndEnabledAt:(NSInteger)addr;
@@ -76,6 +76,14 @@ struct AnyC64FileWrapper { AnyFile *file; };
 {
     wrapper->guards->replace(nr, (u32)addr);
 }
+- (void) setAccess:(NSInteger)nr access:(WatchAccess)access
+{
+    wrapper->guards->setAccess(nr, access);
+}
+- (void) setCondition:(NSInteger)nr mask:(NSInteger)mask value:(NSInteger)value
+{
+    wrapper->guards->setCondition(nr, (u8)mask, (u8)value);
+}
 - (BOOL) isSetAt:(NSInteger)addr
 {
     return wrapper->guards->isSetAt((u32)addr);
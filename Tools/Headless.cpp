@@ -0,0 +1,438 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+#include "Headless.h"
+
+static bool
+readFile(const char *path, std::vector<u8> &buffer)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return false;
+    }
+
+    long size = getSizeOfFile(path);
+    buffer.resize(size > 0 ? size : 0);
+    bool success = fread(buffer.data(), 1, buffer.size(), file) == buffer.size();
+    fclose(file);
+
+    return success;
+}
+
+bool
+RomImages::read(const HeadlessOptions &opt)
+{
+    if (!readFile(opt.basicRom, basic)) return false;
+    if (!readFile(opt.charRom, character)) return false;
+    if (!readFile(opt.kernalRom, kernal)) return false;
+    if (opt.vc1541Rom && !readFile(opt.vc1541Rom, vc1541)) return false;
+
+    return true;
+}
+
+bool
+parseHeadlessOption(int argc, char *argv[], int &i, HeadlessOptions &opt)
+{
+    std::string arg = argv[i];
+
+    if (arg == "--ntsc") { opt.model = C64_NTSC; return true; }
+    if (arg == "--lazy-drives") { opt.lazyDrives = true; return true; }
+    if (arg == "--indexed") { opt.indexed = true; return true; }
+
+    const char *options[] = {
+        "--basic", "--char", "--kernal", "--vc1541", "--prg", "--disk",
+        "--crt", "--type", "--boot", "--frames", "--screenshot", "--ram",
+        "--snapshot", "--render", "--trace", "--profile",
+        "--heatmap"
+    };
+
+    bool known = false;
+    for (const char *o : options) known |= arg == o;
+    if (!known) return false;
+
+    if (i + 1 >= argc) {
+        fprintf(stderr, "Missing argument for %s\n", arg.c_str());
+        exit(1);
+    }
+    const char *val = argv[++i];
+
+    if (arg == "--basic") opt.basicRom = val;
+    if (arg == "--char") opt.charRom = val;
+    if (arg == "--kernal") opt.kernalRom = val;
+    if (arg == "--vc1541") opt.vc1541Rom = val;
+    if (arg == "--prg") opt.prg = val;
+    if (arg == "--disk") opt.disk = val;
+    if (arg == "--crt") opt.crt = val;
+    if (arg == "--type") opt.text += val;
+    if (arg == "--boot") opt.bootFrames = strtol(val, nullptr, 0);
+    if (arg == "--frames") opt.frames = strtol(val, nullptr, 0);
+    if (arg == "--screenshot") opt.screenshot = val;
+    if (arg == "--ram") opt.ramDump = val;
+    if (arg == "--snapshot") opt.snapshot = val;
+    if (arg == "--render") opt.renderInterval = strtol(val, nullptr, 0);
+    if (arg == "--trace") opt.trace = val;
+    if (arg == "--profile") opt.profile = val;
+    if (arg == "--heatmap") opt.heatmap = val;
+
+    return true;
+}
+
+void
+printHeadlessOptions()
+{
+    fprintf(stderr,
+            "  --basic <file>       Basic Rom (required)\n"
+            "  --char <file>        Character Rom (required)\n"
+            "  --kernal <file>      Kernal Rom (required)\n"
+            "  --vc1541 <file>      VC1541 Rom (required for disks)\n"
+            "  --ntsc               Emulate an NTSC machine (default: PAL)\n"
+            "  --lazy-drives        Let the drives catch up with the C64 in batches\n"
+            "  --indexed            Defer the RGBA conversion until a frame is used\n"
+            "  --render <n>         Only draw every n-th frame (default: 1)\n"
+            "  --prg <file>         Flash a PRG, P00 or T64 file and type RUN\n"
+            "  --disk <file>        Insert a D64 or G64 file into drive 8\n"
+            "  --crt <file>         Attach a CRT cartridge\n"
+            "  --type <text>        Type in text after booting ('\\n' = RETURN)\n"
+            "  --boot <n>           Frames to run before flashing (default: 150)\n"
+            "  --frames <n>         Total number of frames to run (default: 300)\n"
+            "  --screenshot <file>  Write the final frame as a PPM image\n"
+            "  --ram <file>         Write the final RAM contents (64 KB)\n"
+            "  --snapshot <file>    Write the final state as a snapshot\n"
+            "  --trace <file>       Record an instruction trace (see c64trace)\n"
+            "  --profile <file>     Write a CPU profile of the C64 and drive 8\n"
+            "  --heatmap <base>     Write memory access heatmaps (needs MEM_HEATMAP)\n");
+}
+
+bool
+validateHeadlessOptions(const HeadlessOptions &opt)
+{
+    if (!opt.basicRom || !opt.charRom || !opt.kernalRom) {
+        fprintf(stderr, "Basic, Character and Kernal Roms are required\n");
+        return false;
+    }
+    if (opt.disk && !opt.vc1541Rom) {
+        fprintf(stderr, "Inserting a disk requires a VC1541 Rom\n");
+        return false;
+    }
+    return true;
+}
+
+bool
+assignMedia(HeadlessOptions &opt, const char *path)
+{
+    if (CRTFile::isCRTFile(path)) { opt.crt = path; return true; }
+    if (D64File::isD64File(path)) { opt.disk = path; return true; }
+    if (G64File::isG64File(path)) { opt.disk = path; return true; }
+    if (PRGFile::isPRGFile(path)) { opt.prg = path; return true; }
+    if (P00File::isP00File(path)) { opt.prg = path; return true; }
+    if (T64File::isT64File(path)) { opt.prg = path; return true; }
+
+    fprintf(stderr, "Unsupported file type: %s\n", path);
+    return false;
+}
+
+bool
+setupHeadless(C64 &c64, const HeadlessOptions &opt, const RomImages &roms)
+{
+    c64.configure(opt.model);
+    c64.configure(OPT_LAZY_DRIVES, opt.lazyDrives);
+    c64.configure(OPT_FRAMEBUFFER,
+                  opt.indexed ? FRAMEBUFFER_INDEXED : FRAMEBUFFER_RGBA);
+    c64.configure(OPT_RENDER_INTERVAL, opt.renderInterval);
+
+    // Flash Roms
+    if (!c64.loadRomFromBuffer(ROM_BASIC, roms.basic.data(), roms.basic.size()) ||
+        !c64.loadRomFromBuffer(ROM_CHAR, roms.character.data(), roms.character.size()) ||
+        !c64.loadRomFromBuffer(ROM_KERNAL, roms.kernal.data(), roms.kernal.size())) {
+        fprintf(stderr, "Failed to load Roms\n");
+        return false;
+    }
+    if (!roms.vc1541.empty()) {
+        if (!c64.loadRomFromBuffer(ROM_VC1541, roms.vc1541.data(), roms.vc1541.size())) {
+            fprintf(stderr, "Failed to load VC1541 Rom\n");
+            return false;
+        }
+        c64.configure(DRIVE8, OPT_DRIVE_CONNECT, true);
+    }
+
+    c64.powerOn();
+    if (!c64.isPoweredOn()) {
+        fprintf(stderr, "Failed to power on\n");
+        return false;
+    }
+    c64.setWarp(true);
+
+    // Attach media
+    if (opt.crt) {
+        CRTFile *crt = CRTFile::makeWithFile(opt.crt);
+        bool success = crt && c64.expansionport.attachCartridgeAndReset(crt);
+        delete crt;
+        if (!success) {
+            fprintf(stderr, "Cannot attach cartridge %s\n", opt.crt);
+            return false;
+        }
+    }
+    if (opt.disk) {
+        AnyArchive *archive = AnyArchive::makeWithFile(opt.disk);
+        if (!archive) {
+            fprintf(stderr, "Cannot read disk file %s\n", opt.disk);
+            return false;
+        }
+        c64.drive8.insertDisk(archive);
+        delete archive;
+    }
+
+    return true;
+}
+
+HeadlessResult
+runHeadless(const HeadlessOptions &opt, const RomImages &roms)
+{
+    HeadlessResult result;
+    u64 start = Oscillator::nanos();
+
+    C64 c64;
+    if (!setupHeadless(c64, opt, roms)) return result;
+    if (!opt.trace.empty() && !c64.cpu.debugger.startTrace(opt.trace.c_str())) {
+        fprintf(stderr, "Cannot create trace file %s\n", opt.trace.c_str());
+        return result;
+    }
+    if (!opt.heatmap.empty() && !c64.mem.setHeatmapRecording(true)) {
+        fprintf(stderr, "Heatmaps require a build with -DVC64_MEM_HEATMAP=ON\n");
+        return result;
+    }
+    if (!opt.profile.empty()) {
+        c64.cpu.setProfiling(true);
+        c64.drive8.cpu.setProfiling(true);
+    }
+
+    bool success = true;
+
+    // Boot
+    if (opt.prg || !opt.text.empty()) {
+
+        std::string text = opt.text;
+        success = runFrames(c64, std::min(opt.bootFrames, opt.frames));
+
+        if (success && opt.prg) {
+            if (!flashProgram(c64, opt.prg)) return result;
+            text = "RUN\n" + text;
+        }
+        success = success && typeText(c64, text);
+    }
+
+    // Run (the last frame is always drawn to get a proper screenshot)
+    if (success && (long)c64.frame < opt.frames) {
+        success = runFrames(c64, opt.frames - (long)c64.frame - 1);
+        c64.configure(OPT_RENDER_INTERVAL, 1);
+        success = success && runFrames(c64, 1);
+    }
+
+    result.frames = c64.frame;
+    result.cycles = c64.cpu.cycle;
+    result.seconds = (Oscillator::nanos() - start) / 1000000000.0;
+
+    // Dump results
+    if (!opt.trace.empty() && !c64.cpu.debugger.stopTrace()) {
+        fprintf(stderr, "Cannot write trace file %s\n", opt.trace.c_str());
+        return result;
+    }
+    if (!opt.screenshot.empty() && !writeScreenshot(c64, opt.screenshot.c_str())) return result;
+    if (!opt.ramDump.empty() && !writeRam(c64, opt.ramDump.c_str())) return result;
+    if (!opt.snapshot.empty() && !writeSnapshot(c64, opt.snapshot.c_str())) return result;
+    if (!opt.profile.empty() && !writeProfile(c64, opt.profile.c_str())) return result;
+    if (!opt.heatmap.empty() && !writeHeatmap(c64, opt.heatmap.c_str())) return result;
+
+    result.status = success ? 0 : 2;
+    return result;
+}
+
+bool
+runFrames(C64 &c64, long count)
+{
+    for (long i = 0; i < count; i++) {
+
+        c64.executeOneFrame();
+
+        if (u32 flags = c64.getControlFlags()) {
+
+            if (flags & RL_CPU_JAMMED) {
+                fprintf(stderr, "CPU jammed in frame %lld (PC = %04X)\n",
+                        (long long)c64.frame, c64.cpu.getPC0());
+                return false;
+            }
+
+            // Ignore all other requests (snapshots, inspection, etc.)
+            c64.clearControlFlags(flags);
+        }
+    }
+    return true;
+}
+
+bool
+typeText(C64 &c64, const std::string &text)
+{
+    // The Kernal's keyboard buffer holds at most ten characters
+    const u16 bufferAddr = 0x0277;
+    const u16 countAddr = 0x00C6;
+    const size_t bufferSize = 10;
+
+    size_t pos = 0;
+    while (pos < text.size()) {
+
+        // Wait until the buffer has been drained
+        for (int i = 0; c64.mem.ram[countAddr] != 0; i++) {
+            if (i > 500 || !runFrames(c64, 1)) return false;
+        }
+
+        u8 count = 0;
+        while (pos < text.size() && count < bufferSize) {
+
+            char c = text[pos++];
+
+            // Translate escape sequences and lower case letters to PETSCII
+            if (c == '\\' && pos < text.size() && text[pos] == 'n') { pos++; c = '\r'; }
+            if (c == '\n') c = '\r';
+            if (c >= 'a' && c <= 'z') c -= 'a' - 'A';
+
+            c64.mem.ram[bufferAddr + count++] = (u8)c;
+        }
+        c64.mem.ram[countAddr] = count;
+    }
+    return true;
+}
+
+bool
+flashProgram(C64 &c64, const char *path)
+{
+    AnyArchive *archive = AnyArchive::makeWithFile(path);
+    if (!archive) {
+        fprintf(stderr, "Cannot read program file %s\n", path);
+        return false;
+    }
+
+    archive->selectItem(0);
+    u16 start = archive->getDestinationAddrOfItem();
+    u16 end = (u16)(start + archive->getSizeOfItem());
+
+    c64.flash(archive, 0);
+
+    if (start == 0x0801) {
+        for (u16 addr = 0x2D; addr <= 0x31; addr += 2) {
+            c64.mem.ram[addr] = LO_BYTE(end);
+            c64.mem.ram[addr + 1] = HI_BYTE(end);
+        }
+    }
+
+    delete archive;
+    return true;
+}
+
+bool
+writeScreenshot(C64 &c64, const char *path)
+{
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        fprintf(stderr, "Cannot create %s\n", path);
+        return false;
+    }
+
+    long width = VISIBLE_PIXELS;
+    long height = c64.vic.numVisibleRasterlines();
+
+    fprintf(file, "P6\n%ld %ld\n255\n", width, height);
+
+    std::vector<u32> pixels(width * height);
+    c64.vic.convertFinishedFrame(pixels.data(), PIXEL_RGBA);
+
+    bool success = true;
+    std::vector<u8> line(width * 3);
+    for (long y = 0; success && y < height; y++) {
+
+        // Pixels are stored in RGBA byte order
+        const u32 *row = pixels.data() + y * width;
+        for (long x = 0; x < width; x++) {
+            line[3 * x + 0] = row[x] & 0xFF;
+            line[3 * x + 1] = (row[x] >> 8) & 0xFF;
+            line[3 * x + 2] = (row[x] >> 16) & 0xFF;
+        }
+        success = fwrite(line.data(), 1, line.size(), file) == line.size();
+    }
+
+    success = fclose(file) == 0 && success;
+    if (!success) fprintf(stderr, "Cannot write %s\n", path);
+    return success;
+}
+
+bool
+writeRam(C64 &c64, const char *path)
+{
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        fprintf(stderr, "Cannot create %s\n", path);
+        return false;
+    }
+
+    bool success = fwrite(c64.mem.ram, 1, 0x10000, file) == 0x10000;
+    success = fclose(file) == 0 && success;
+    if (!success) fprintf(stderr, "Cannot write %s\n", path);
+    return success;
+}
+
+bool
+writeSnapshot(C64 &c64, const char *path)
+{
+    Snapshot *snapshot = Snapshot::makeWithC64(&c64);
+    bool success = snapshot->writeToFile(path);
+    delete snapshot;
+
+    if (!success) fprintf(stderr, "Cannot create %s\n", path);
+    return success;
+}
+
+bool
+writeProfile(C64 &c64, const char *path)
+{
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "Cannot create %s\n", path);
+        return false;
+    }
+
+    if (CPUProfiler *profiler = c64.cpu.profiler) {
+        profiler->writeFlatProfile(file, "C64 CPU");
+        profiler->writeCallgraph(file, "C64 CPU");
+    }
+    if (CPUProfiler *profiler = c64.drive8.cpu.profiler) {
+        profiler->writeFlatProfile(file, "Drive 8 CPU");
+        profiler->writeCallgraph(file, "Drive 8 CPU");
+    }
+
+    bool success = !ferror(file);
+    success = fclose(file) == 0 && success;
+    if (!success) fprintf(stderr, "Cannot write %s\n", path);
+    return success;
+}
+
+bool
+writeHeatmap(C64 &c64, const char *base)
+{
+    MemHeatmap *heatmap = c64.mem.heatmap;
+    if (!heatmap) return false;
+
+    std::string path = base;
+    if (!heatmap->writeImage((path + ".ppm").c_str()) ||
+        !heatmap->writePages((path + "-pages.csv").c_str()) ||
+        !heatmap->writeTimeline((path + "-frames.csv").c_str())) {
+        fprintf(stderr, "Cannot write heatmap %s\n", base);
+        return false;
+    }
+    return true;
+}
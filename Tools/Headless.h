@@ -0,0 +1,145 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+/* Shared code of the command line tools. A headless session creates a C64,
+ * flashes the Roms, attaches a program, disk or cartridge, and emulates a
+ * fixed number of frames in warp mode. The emulator thread is never launched.
+ * All frames are executed on the calling thread via C64::executeOneFrame().
+ * Sessions don't share any state, so multiple sessions can be executed in
+ * parallel threads.
+ */
+
+#ifndef _HEADLESS_H
+#define _HEADLESS_H
+
+#include "C64.h"
+
+#include <string>
+#include <vector>
+
+struct HeadlessOptions {
+
+    // Rom images
+    const char *basicRom = nullptr;
+    const char *charRom = nullptr;
+    const char *kernalRom = nullptr;
+    const char *vc1541Rom = nullptr;
+
+    // Machine model
+    C64Model model = C64_PAL;
+    
+    // Emulate the drives lazily (see IEC::catchUpDrives())
+    bool lazyDrives = false;
+
+    // Draw frames as color indices (see FramebufferFormat)
+    bool indexed = false;
+
+    // Only draw every n-th frame (see VICII::skipFrame)
+    long renderInterval = 1;
+
+    // Media to attach
+    const char *prg = nullptr;
+    const char *disk = nullptr;
+    const char *crt = nullptr;
+
+    // Text that is typed in after the boot phase
+    std::string text;
+
+    // Number of frames to emulate before the program is flashed
+    long bootFrames = 150;
+
+    // Number of frames to emulate
+    long frames = 300;
+
+    // Output files
+    std::string screenshot;
+    std::string ramDump;
+    std::string snapshot;
+    std::string trace;
+    std::string profile;
+    std::string heatmap;
+};
+
+// Rom images, read once and shared by all sessions
+struct RomImages {
+
+    std::vector<u8> basic;
+    std::vector<u8> character;
+    std::vector<u8> kernal;
+    std::vector<u8> vc1541;
+
+    // Reads all Roms specified in the options
+    bool read(const HeadlessOptions &opt);
+};
+
+// Result of a headless session
+struct HeadlessResult {
+
+    // Exit code (0 = success, 1 = setup error, 2 = emulation stopped early)
+    int status = 1;
+
+    u64 frames = 0;
+    u64 cycles = 0;
+
+    // Wall clock time spent in the session
+    double seconds = 0.0;
+};
+
+/* Parses a command line option shared by all tools. If argv[i] is a known
+ * option, its argument is consumed, i is advanced, and true is returned.
+ */
+bool parseHeadlessOption(int argc, char *argv[], int &i, HeadlessOptions &opt);
+
+// Prints the shared command line options
+void printHeadlessOptions();
+
+// Checks if all required options are given
+bool validateHeadlessOptions(const HeadlessOptions &opt);
+
+// Attaches a file as program, disk, or cartridge, based on its type
+bool assignMedia(HeadlessOptions &opt, const char *path);
+
+// Runs a headless session
+HeadlessResult runHeadless(const HeadlessOptions &opt, const RomImages &roms);
+
+// Sets up a C64 and attaches media as specified in the options
+bool setupHeadless(C64 &c64, const HeadlessOptions &opt, const RomImages &roms);
+
+/* Emulates the specified number of frames. The function returns false if the
+ * run loop has been signalled to stop, e.g., because the CPU jammed.
+ */
+bool runFrames(C64 &c64, long count);
+
+/* Feeds text into the Kernal's keyboard buffer. '\n' and the two character
+ * sequence "\n" are translated to RETURN.
+ */
+bool typeText(C64 &c64, const std::string &text);
+
+/* Flashes the first item of an archive into memory. If the program is located
+ * at the start of the Basic area, the Basic pointers are adjusted as if the
+ * program had been loaded with LOAD.
+ */
+bool flashProgram(C64 &c64, const char *path);
+
+// Writes the visible area of the last finished frame as a PPM image
+bool writeScreenshot(C64 &c64, const char *path);
+
+// Writes the 64 KB of RAM
+bool writeRam(C64 &c64, const char *path);
+
+// Writes a snapshot of the current emulator state
+bool writeSnapshot(C64 &c64, const char *path);
+
+// Writes the flat profiles and callgraphs of the C64 CPU and the first drive
+bool writeProfile(C64 &c64, const char *path);
+
+// Writes the memory heatmap to <base>.ppm, <base>-pages.csv, <base>-frames.csv
+bool writeHeatmap(C64 &c64, const char *base);
+
+#endif
@@ -0,0 +1,168 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+/* c64batch runs many headless sessions in parallel. Each image (PRG, P00,
+ * T64, D64, G64, or CRT) is emulated in its own C64 instance. The instances
+ * are distributed across a pool of worker threads. Each worker picks the next
+ * pending image, runs it to completion, and moves on. Because the instances
+ * don't share any state, throughput scales with the number of cores.
+ *
+ * For each image, a result line is printed to stdout:
+ *
+ *     <status> <frames> <cycles> <seconds> <path>
+ */
+
+#include "Headless.h"
+
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+struct BatchJob {
+
+    std::string path;
+    HeadlessResult result;
+};
+
+static void
+usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s [options] <image> [<image> ...]\n\n", prog);
+    fprintf(stderr,
+            "  --jobs <n>           Number of worker threads (default: all cores)\n"
+            "  --list <file>        Read image paths from a file (one per line)\n"
+            "  --out <dir>          Write a screenshot and a RAM dump per image\n");
+    printHeadlessOptions();
+}
+
+static std::string
+baseName(const std::string &path)
+{
+    char *name = extractFilenameWithoutSuffix(path.c_str());
+    std::string result = name;
+    free(name);
+    return result;
+}
+
+int
+main(int argc, char *argv[])
+{
+    HeadlessOptions opt;
+    std::vector<BatchJob> jobs;
+    unsigned workers = std::thread::hardware_concurrency();
+    const char *outDir = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+
+        std::string arg = argv[i];
+
+        if (parseHeadlessOption(argc, argv, i, opt)) continue;
+
+        if ((arg == "--jobs" || arg == "--list" || arg == "--out") && i + 1 < argc) {
+
+            const char *val = argv[++i];
+
+            if (arg == "--jobs") workers = (unsigned)strtol(val, nullptr, 0);
+            if (arg == "--out") outDir = val;
+            if (arg == "--list") {
+                std::ifstream list(val);
+                if (!list) {
+                    fprintf(stderr, "Cannot open %s\n", val);
+                    return 1;
+                }
+                for (std::string line; std::getline(list, line); ) {
+                    if (!line.empty()) jobs.push_back(BatchJob { line });
+                }
+            }
+            continue;
+        }
+        if (arg[0] == '-') {
+            if (arg != "--help" && arg != "-h") {
+                fprintf(stderr, "Unknown option: %s\n", arg.c_str());
+            }
+            usage(argv[0]);
+            return 1;
+        }
+        jobs.push_back(BatchJob { arg });
+    }
+
+    if (!validateHeadlessOptions(opt) || jobs.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (opt.prg || opt.disk || opt.crt) {
+        fprintf(stderr, "Media options can't be used in batch mode\n");
+        return 1;
+    }
+    if (!opt.trace.empty() || !opt.profile.empty() || !opt.heatmap.empty()) {
+        fprintf(stderr, "Tracing and profiling can't be used in batch mode\n");
+        return 1;
+    }
+
+    RomImages roms;
+    if (!roms.read(opt)) return 1;
+
+    workers = std::max(1u, std::min(workers, (unsigned)jobs.size()));
+
+    std::atomic<size_t> next(0);
+    std::mutex outputLock;
+
+    auto worker = [&]() {
+
+        size_t nr;
+        while ((nr = next++) < jobs.size()) {
+
+            BatchJob &job = jobs[nr];
+
+            // Derive the session options from the shared options
+            HeadlessOptions jobOpt = opt;
+            if (!assignMedia(jobOpt, job.path.c_str())) continue;
+            if (jobOpt.disk && roms.vc1541.empty()) {
+                fprintf(stderr, "Skipping %s (VC1541 Rom missing)\n", job.path.c_str());
+                continue;
+            }
+            if (jobOpt.disk && jobOpt.text.empty()) {
+                jobOpt.text = "LOAD\"*\",8,1\nRUN\n";
+            }
+            if (outDir) {
+                std::string prefix = std::string(outDir) + "/" + baseName(job.path);
+                jobOpt.screenshot = prefix + ".ppm";
+                jobOpt.ramDump = prefix + ".ram";
+            }
+
+            job.result = runHeadless(jobOpt, roms);
+
+            std::lock_guard<std::mutex> guard(outputLock);
+            printf("%d %llu %llu %.3f %s\n",
+                   job.result.status, job.result.frames, job.result.cycles,
+                   job.result.seconds, job.path.c_str());
+            fflush(stdout);
+        }
+    };
+
+    u64 start = Oscillator::nanos();
+
+    std::vector<std::thread> pool;
+    for (unsigned i = 0; i < workers; i++) pool.push_back(std::thread(worker));
+    for (std::thread &t : pool) t.join();
+
+    double elapsed = (Oscillator::nanos() - start) / 1000000000.0;
+
+    // Summarize
+    u64 frames = 0, failed = 0;
+    for (BatchJob &job : jobs) {
+        frames += job.result.frames;
+        failed += job.result.status != 0;
+    }
+    fprintf(stderr, "%zu images, %llu failed, %u workers, %.3f sec, %.1f frames/sec\n",
+            jobs.size(), failed, workers, elapsed, elapsed > 0 ? frames / elapsed : 0);
+
+    return failed ? 2 : 0;
+}
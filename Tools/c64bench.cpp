@@ -0,0 +1,302 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+/* c64bench measures the throughput of the per-cycle hot path. For each
+ * snapshot in the corpus, the emulator state is restored before every
+ * measurement and a fixed number of cycles is emulated. The following
+ * benchmarks are available:
+ *
+ *     c64      : The complete cycle (C64::executeOneCycle())
+ *     lines    : Complete rasterlines (C64::executeOneLine())
+ *     vicii    : VICII function table dispatch (vicfunc[])
+ *     cia      : CIA::executeOneCycle() for both CIAs
+ *     cpu      : CPU<C64Memory>::executeOneCycle()
+ *     drive    : Drive::execute() for the first drive
+ *     drivecpu : CPU<DriveMemory>::executeOneCycle() for the first drive
+ *     sid      : SIDBridge::executeUntil(), called once per frame
+ *
+ * The component benchmarks emulate the respective component in isolation,
+ * i.e., all other components are frozen. In addition, the restore benchmark
+ * measures how long it takes to restore the snapshot (C64::loadFromSnapshot()).
+ * Results are written in JSON format.
+ * Snapshots can be created with c64run --snapshot.
+ */
+
+#include "Headless.h"
+
+#include <functional>
+
+struct Benchmark {
+
+    const char *name;
+    std::function<void(C64 &c64, u64 cycles)> run;
+};
+
+static void
+benchC64(C64 &c64, u64 cycles)
+{
+    for (u64 i = 0; i < cycles; i++) c64.executeOneCycle();
+}
+
+static void
+benchLines(C64 &c64, u64 cycles)
+{
+    u64 end = c64.cpu.cycle + cycles;
+    while (c64.cpu.cycle < end) c64.executeOneLine();
+}
+
+static void
+benchVICII(C64 &c64, u64 cycles)
+{
+    VICII &vic = c64.vic;
+    unsigned cyclesPerLine = vic.getCyclesPerLine();
+    long linesPerFrame = vic.getRasterlinesPerFrame();
+
+    for (u64 i = 0; i < cycles; i++) {
+
+        if (c64.rasterCycle == 1) {
+            if (c64.rasterLine == 0) vic.beginFrame();
+            vic.beginRasterline(c64.rasterLine);
+        }
+
+        c64.cpu.cycle++;
+        (vic.*c64.vicfunc[c64.rasterCycle])();
+
+        if (c64.rasterCycle++ == cyclesPerLine) {
+            vic.endRasterline();
+            c64.rasterCycle = 1;
+            if (++c64.rasterLine >= linesPerFrame) {
+                c64.rasterLine = 0;
+                vic.endFrame();
+            }
+        }
+    }
+}
+
+static void
+benchCIA(C64 &c64, u64 cycles)
+{
+    for (u64 i = 0; i < cycles; i++) {
+
+        Cycle cycle = ++c64.cpu.cycle;
+        if (cycle >= c64.cia1.wakeUpCycle) c64.cia1.executeOneCycle();
+        if (cycle >= c64.cia2.wakeUpCycle) c64.cia2.executeOneCycle();
+    }
+}
+
+static void
+benchCPU(C64 &c64, u64 cycles)
+{
+    for (u64 i = 0; i < cycles; i++) {
+
+        c64.cpu.cycle++;
+        c64.cpu.executeOneCycle();
+    }
+}
+
+static void
+benchDriveCPU(C64 &c64, u64 cycles)
+{
+    for (u64 i = 0; i < cycles; i++) {
+
+        c64.drive8.cpu.cycle++;
+        c64.drive8.cpu.executeOneCycle();
+    }
+}
+
+static void
+benchDrive(C64 &c64, u64 cycles)
+{
+    for (u64 i = 0; i < cycles; i++) {
+        c64.drive8.execute(c64.durationOfOneCycle);
+    }
+}
+
+static void
+benchSID(C64 &c64, u64 cycles)
+{
+    u64 cyclesPerFrame = c64.vic.getCyclesPerFrame();
+
+    for (u64 i = 0; i < cycles; i += cyclesPerFrame) {
+
+        c64.cpu.cycle += std::min(cyclesPerFrame, cycles - i);
+        c64.sid.executeUntil(c64.cpu.cycle);
+    }
+}
+
+static const Benchmark benchmarks[] = {
+
+    { "c64", benchC64 },
+    { "lines", benchLines },
+    { "vicii", benchVICII },
+    { "cia", benchCIA },
+    { "cpu", benchCPU },
+    { "drive", benchDrive },
+    { "drivecpu", benchDriveCPU },
+    { "sid", benchSID }
+};
+
+static void
+usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s [options] <snapshot> [<snapshot> ...]\n\n", prog);
+    fprintf(stderr,
+            "  --cycles <n>         Cycles per measurement (default: 2000000)\n"
+            "  --repeat <n>         Measurements per benchmark, best is reported (default: 3)\n"
+            "  --only <name>        Run a single benchmark (c64, lines, vicii, cia, cpu, drive,\n"
+            "                       drivecpu, sid, restore)\n"
+            "  --output <file>      Write results to a file (default: stdout)\n");
+}
+
+// Number of restores per measurement in the restore benchmark
+static const long restores = 100;
+
+// Restores a snapshot and prepares the emulator for headless execution
+static void
+restore(C64 &c64, Snapshot *snapshot)
+{
+    c64.loadFromSnapshot(snapshot);
+    c64.updateVicFunctionTable();
+    c64.setWarp(true);
+}
+
+static std::string
+baseName(const char *path)
+{
+    char *name = extractFilename(path);
+    std::string result = name;
+    free(name);
+    return result;
+}
+
+int
+main(int argc, char *argv[])
+{
+    u64 cycles = 2000000;
+    long repeat = 3;
+    const char *only = nullptr;
+    const char *output = nullptr;
+    std::vector<const char *> corpus;
+
+    for (int i = 1; i < argc; i++) {
+
+        std::string arg = argv[i];
+
+        if (arg == "--help" || arg == "-h") { usage(argv[0]); return 0; }
+
+        if (arg[0] == '-') {
+
+            if (i + 1 >= argc) { usage(argv[0]); return 1; }
+            const char *val = argv[++i];
+
+            if (arg == "--cycles") cycles = strtoull(val, nullptr, 0);
+            else if (arg == "--repeat") repeat = std::max(1L, strtol(val, nullptr, 0));
+            else if (arg == "--only") only = val;
+            else if (arg == "--output") output = val;
+            else {
+                fprintf(stderr, "Unknown option: %s\n", arg.c_str());
+                usage(argv[0]);
+                return 1;
+            }
+            continue;
+        }
+        corpus.push_back(argv[i]);
+    }
+
+    if (corpus.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    FILE *out = output ? fopen(output, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "Cannot create %s\n", output);
+        return 1;
+    }
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"version\": \"%d.%d.%d\",\n", V_MAJOR, V_MINOR, V_SUBMINOR);
+    fprintf(out, "  \"cycles\": %llu,\n", cycles);
+    fprintf(out, "  \"repeat\": %ld,\n", repeat);
+    fprintf(out, "  \"results\": [");
+
+    bool first = true;
+    for (const char *path : corpus) {
+
+        Snapshot *snapshot = Snapshot::makeWithFile(path);
+        if (!snapshot || !Snapshot::isSupportedSnapshotFile(path)) {
+            fprintf(stderr, "Skipping %s (no supported snapshot)\n", path);
+            delete snapshot;
+            continue;
+        }
+
+        // Power on with the Roms stored in the snapshot
+        C64 c64;
+        c64.loadFromSnapshot(snapshot);
+        c64.powerOn();
+        std::string name = baseName(path);
+
+        for (const Benchmark &bench : benchmarks) {
+
+            if (only && strcmp(only, bench.name)) continue;
+
+            // Keep the best of all runs to filter out scheduling noise
+            u64 best = UINT64_MAX;
+            for (long r = 0; r < repeat; r++) {
+
+                restore(c64, snapshot);
+
+                u64 start = Oscillator::nanos();
+                bench.run(c64, cycles);
+                best = std::min(best, Oscillator::nanos() - start);
+            }
+
+            double seconds = best / 1000000000.0;
+            double rate = seconds > 0 ? cycles / seconds : 0;
+
+            fprintf(out, "%s\n    { \"snapshot\": \"%s\", \"benchmark\": \"%s\", "
+                    "\"seconds\": %.6f, \"cyclesPerSecond\": %.0f }",
+                    first ? "" : ",", name.c_str(), bench.name, seconds, rate);
+            first = false;
+
+            fprintf(stderr, "%-24s %-8s %12.0f cycles/sec\n",
+                    name.c_str(), bench.name, rate);
+        }
+
+        // Measure how long it takes to restore the snapshot
+        if (!only || !strcmp(only, "restore")) {
+
+            u64 best = UINT64_MAX;
+            for (long r = 0; r < repeat; r++) {
+
+                u64 start = Oscillator::nanos();
+                for (long i = 0; i < restores; i++) c64.loadFromSnapshot(snapshot);
+                best = std::min(best, Oscillator::nanos() - start);
+            }
+
+            double seconds = best / 1000000000.0 / restores;
+            double rate = seconds > 0 ? 1 / seconds : 0;
+
+            fprintf(out, "%s\n    { \"snapshot\": \"%s\", \"benchmark\": \"restore\", "
+                    "\"seconds\": %.9f, \"restoresPerSecond\": %.0f }",
+                    first ? "" : ",", name.c_str(), seconds, rate);
+            first = false;
+
+            fprintf(stderr, "%-24s %-8s %12.0f restores/sec (%.1f us)\n",
+                    name.c_str(), "restore", rate, seconds * 1000000);
+        }
+
+        delete snapshot;
+    }
+
+    fprintf(out, "\n  ]\n}\n");
+    if (out != stdout) fclose(out);
+
+    return 0;
+}
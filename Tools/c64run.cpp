@@ -0,0 +1,54 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+/* c64run is a headless front end for the emulator core. It creates a C64,
+ * flashes the Roms, attaches a program, disk or cartridge, emulates a fixed
+ * number of frames in warp mode, and dumps the final texture and RAM contents.
+ */
+
+#include "Headless.h"
+
+static void
+usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s [options]\n\n", prog);
+    printHeadlessOptions();
+}
+
+int
+main(int argc, char *argv[])
+{
+    HeadlessOptions opt;
+
+    for (int i = 1; i < argc; i++) {
+
+        if (!parseHeadlessOption(argc, argv, i, opt)) {
+            if (strcmp(argv[i], "--help") && strcmp(argv[i], "-h")) {
+                fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            }
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!validateHeadlessOptions(opt)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    RomImages roms;
+    if (!roms.read(opt)) return 1;
+
+    HeadlessResult result = runHeadless(opt, roms);
+    if (result.status != 1) {
+        fprintf(stderr, "Emulated %llu frames (%llu cycles) in %.3f sec\n",
+                result.frames, result.cycles, result.seconds);
+    }
+
+    return result.status;
+}
@@ -0,0 +1,106 @@
+// -----------------------------------------------------------------------------
+// This file is part of VirtualC64
+//
+// Copyright (C) Dirk W. Hoffmann. www.dirkwhoffmann.de
+// Licensed under the GNU General Public License v2
+//
+// See https://www.gnu.org for license information
+// -----------------------------------------------------------------------------
+
+/* c64trace reads an instruction trace recorded with c64run --trace (or
+ * CPUDebugger::startTrace()) and prints a disassembly listing. Each line
+ * shows the cycle and the register contents after the instruction has been
+ * executed. The disassembler tables are taken from the CPU debugger of a
+ * C64 instance, so no Roms are required.
+ */
+
+#include "Headless.h"
+
+static void
+usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s [options] <trace>\n\n", prog);
+    fprintf(stderr,
+            "  --skip <n>           Skip the first n instructions\n"
+            "  --count <n>          Print at most n instructions\n"
+            "  --dec                Print decimal numbers\n"
+            "  --summary            Only print the number of instructions and cycles\n");
+}
+
+int
+main(int argc, char *argv[])
+{
+    u64 skip = 0;
+    u64 count = UINT64_MAX;
+    bool hex = true;
+    bool summary = false;
+    const char *path = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+
+        std::string arg = argv[i];
+
+        if (arg == "--help" || arg == "-h") { usage(argv[0]); return 0; }
+        if (arg == "--dec") { hex = false; continue; }
+        if (arg == "--summary") { summary = true; continue; }
+
+        if (arg[0] == '-') {
+
+            if (i + 1 >= argc) { usage(argv[0]); return 1; }
+            const char *val = argv[++i];
+
+            if (arg == "--skip") skip = strtoull(val, nullptr, 0);
+            else if (arg == "--count") count = strtoull(val, nullptr, 0);
+            else {
+                fprintf(stderr, "Unknown option: %s\n", arg.c_str());
+                usage(argv[0]);
+                return 1;
+            }
+            continue;
+        }
+        path = argv[i];
+    }
+
+    if (!path) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    C64 c64;
+    CPUDebugger &debugger = c64.cpu.debugger;
+    debugger.hex = hex;
+
+    u8 lengths[256];
+    debugger.getInstructionLengths(lengths);
+    TraceReader reader(lengths);
+
+    if (!reader.open(path)) {
+        fprintf(stderr, "Cannot read trace file %s\n", path);
+        return 1;
+    }
+
+    RecordedInstruction instr;
+    u64 nr = 0, first = 0, last = 0;
+
+    for (; nr < skip + count && reader.read(instr); nr++) {
+
+        if (nr == 0) first = instr.cycle;
+        last = instr.cycle;
+
+        if (summary || nr < skip) continue;
+
+        printf(hex ? "%12llu  %04X  %-9s  %-11s  A=%02X X=%02X Y=%02X SP=%02X  %s\n" :
+               "%12llu  %05d  %-12s  %-11s  A=%03d X=%03d Y=%03d SP=%03d  %s\n",
+               instr.cycle, instr.pc,
+               debugger.disassembleBytes(instr),
+               debugger.disassembleInstr(instr, nullptr),
+               instr.a, instr.x, instr.y, instr.sp,
+               debugger.disassembleRecordedFlags(instr));
+    }
+
+    if (summary) {
+        printf("%llu instructions, %llu cycles\n", nr, nr ? last - first : 0);
+    }
+
+    return 0;
+}